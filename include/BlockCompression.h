@@ -0,0 +1,39 @@
+//
+//  BlockCompression.h
+//  Shaders
+//
+//  Created by Crunchy on 7/6/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  BC1 (DXT1) and BC3 (DXT5) encoding for the texture baker, and the
+//  matching decoder for error measurement and for drivers without
+//  S3TC. The encoder fits each 4x4 block's colour bounding box, insets
+//  it, and projects texels onto the axis between the endpoints; the
+//  projection runs four texels at a time with SSE2 where available.
+//  Blocks are split across a ThreadPool by rows of blocks.
+//
+
+#ifndef BlockCompression_h
+#define BlockCompression_h
+
+#include "TextureContainer.h"
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+// Packed 8-bit image of 3 or 4 channels -> BC1 or BC3 blocks, rows of
+// blocks top to bottom. Edge blocks repeat the last row and column.
+std::vector<unsigned char> CompressBlocks(TextureFormat format, const unsigned char * pixels,
+                                          int width, int height, int channels, ThreadPool * pool = nullptr);
+
+// Blocks -> packed RGBA8
+std::vector<unsigned char> DecompressBlocks(TextureFormat format, const unsigned char * blocks,
+                                            int width, int height);
+
+// Peak signal to noise ratio in dB over the first `channels` channels
+// of a packed image against its RGBA8 round trip. Infinite if equal.
+double BlockPsnr(const unsigned char * original, int channels, const unsigned char * rgba, int width, int height);
+
+#endif
@@ -0,0 +1,194 @@
+//
+//  EmbeddedShaderData.h
+//  Shaders
+//
+//  Generated by source/tools/embed_shaders.cpp. Do not edit.
+//
+
+// Included by EmbeddedShaders.cpp only
+
+#ifndef EmbeddedShaderData_h
+#define EmbeddedShaderData_h
+
+#include "EmbeddedShaders.h"
+
+namespace EmbeddedShaderData
+{
+    // fragment/base.fs
+    constexpr char fragment_base_fs[] =
+        "#version 330 core\n"
+        "layout(location = 0) out vec4 Color;\n"
+        "\n"
+        "in vec3 Fragment;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    Color = vec4(Fragment, 1.0);\n"
+        "}\n";
+
+    // fragment/base.texture.fs
+    constexpr char fragment_base_texture_fs[] =
+        "#version 330 core\n"
+        "layout(location = 0) out vec4 Color;\n"
+        "\n"
+        "in vec3 Fragment;\n"
+        "in vec2 TexCoord;\n"
+        "\n"
+        "uniform sampler2D uTexture;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    Color = texture(uTexture, TexCoord);\n"
+        "}\n";
+
+    // fragment/blend.texture2.array.fs
+    constexpr char fragment_blend_texture2_array_fs[] =
+        "#version 330 core\n"
+        "#include \"../include/texture.inputs.glsl\"\n"
+        "\n"
+        "// blend.texture2.fs with both images as layers of one array texture,\n"
+        "// so a whole batch of materials draws from a single bind. Pair with\n"
+        "// vertex/base.array.vs.\n"
+        "\n"
+        "flat in ivec2 Layers;\n"
+        "\n"
+        "uniform sampler2DArray uTextures;\n"
+        "uniform float uBlend = 0.5;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    Color = mix\n"
+        "    (\n"
+        "        texture(uTextures, vec3(TexCoord, Layers.x)),\n"
+        "        texture(uTextures, vec3(TexCoord, Layers.y)),\n"
+        "        uBlend\n"
+        "    );\n"
+        "}\n";
+
+    // fragment/blend.texture2.fs
+    constexpr char fragment_blend_texture2_fs[] =
+        "#version 330 core\n"
+        "layout(location = 0) out vec4 Color;\n"
+        "\n"
+        "in vec3 Fragment;\n"
+        "in vec2 TexCoord;\n"
+        "\n"
+        "uniform sampler2D uTexture1;\n"
+        "uniform sampler2D uTexture2;\n"
+        "uniform float uBlend = 0.5;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    Color = mix\n"
+        "    (\n"
+        "        texture(uTexture1, TexCoord),\n"
+        "        texture(uTexture2, TexCoord),\n"
+        "        uBlend\n"
+        "    );\n"
+        "}\n";
+
+    // fragment/texture.fs
+    constexpr char fragment_texture_fs[] =
+        "#version 330 core\n"
+        "#include \"../include/texture.inputs.glsl\"\n"
+        "\n"
+        "// Permutations:\n"
+        "//   (none)          single texture\n"
+        "//   BLEND_TEXTURE2  mix uTexture1 and uTexture2 by uBlend\n"
+        "\n"
+        "uniform sampler2D uTexture1;\n"
+        "\n"
+        "#ifdef BLEND_TEXTURE2\n"
+        "uniform sampler2D uTexture2;\n"
+        "uniform float uBlend = 0.5;\n"
+        "#endif\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "#ifdef BLEND_TEXTURE2\n"
+        "    Color = mix\n"
+        "    (\n"
+        "        texture(uTexture1, TexCoord),\n"
+        "        texture(uTexture2, TexCoord),\n"
+        "        uBlend\n"
+        "    );\n"
+        "#else\n"
+        "    Color = texture(uTexture1, TexCoord);\n"
+        "#endif\n"
+        "}\n";
+
+    // include/texture.inputs.glsl
+    constexpr char include_texture_inputs_glsl[] =
+        "layout(location = 0) out vec4 Color;\n"
+        "\n"
+        "in vec3 Fragment;\n"
+        "in vec2 TexCoord;\n";
+
+    // vertex/base.array.vs
+    constexpr char vertex_base_array_vs[] =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 Vertex;\n"
+        "layout (location = 1) in vec3 ColorVec;\n"
+        "layout (location = 2) in vec2 TextureVec;\n"
+        "\n"
+        "// Permutations:\n"
+        "//   (none)           layers from uLayers, per draw\n"
+        "//   LAYER_ATTRIBUTE  layers from an integer attribute, per vertex or, with\n"
+        "//                    glVertexAttribDivisor, per instance\n"
+        "\n"
+        "#ifdef LAYER_ATTRIBUTE\n"
+        "layout (location = 3) in ivec2 LayerVec;\n"
+        "#else\n"
+        "uniform ivec2 uLayers;\n"
+        "#endif\n"
+        "\n"
+        "out vec3 Fragment;\n"
+        "out vec2 TexCoord;\n"
+        "flat out ivec2 Layers;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(Vertex, 1.0);\n"
+        "    Fragment = ColorVec;\n"
+        "    TexCoord  = TextureVec;\n"
+        "#ifdef LAYER_ATTRIBUTE\n"
+        "    Layers = LayerVec;\n"
+        "#else\n"
+        "    Layers = uLayers;\n"
+        "#endif\n"
+        "}\n";
+
+    // vertex/base.vs
+    constexpr char vertex_base_vs[] =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 Vertex;\n"
+        "layout (location = 1) in vec3 ColorVec;\n"
+        "layout (location = 2) in vec2 TextureVec;\n"
+        "  \n"
+        "out vec3 Fragment;\n"
+        "out vec2 TexCoord;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    gl_Position = vec4(Vertex, 1.0);\n"
+        "    Fragment = ColorVec;\n"
+        "    TexCoord  = TextureVec;\n"
+        "}\n";
+
+    // In ShaderResource order
+    constexpr EmbeddedFile Files[] =
+    {
+        { "fragment/base.fs", fragment_base_fs, 124 },
+        { "fragment/base.texture.fs", fragment_base_texture_fs, 179 },
+        { "fragment/blend.texture2.array.fs", fragment_blend_texture2_array_fs, 480 },
+        { "fragment/blend.texture2.fs", fragment_blend_texture2_fs, 316 },
+        { "fragment/texture.fs", fragment_texture_fs, 504 },
+        { "include/texture.inputs.glsl", include_texture_inputs_glsl, 74 },
+        { "vertex/base.array.vs", vertex_base_array_vs, 693 },
+        { "vertex/base.vs", vertex_base_vs, 286 },
+    };
+
+    static_assert(sizeof(Files) / sizeof(Files[0]) == SHADER_RESOURCE_COUNT, "Regenerate ShaderResources.h");
+}
+
+#endif
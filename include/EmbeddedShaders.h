@@ -0,0 +1,59 @@
+//
+//  EmbeddedShaders.h
+//  Shaders
+//
+//  Created by Crunchy on 6/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  shaders/ compiled into the binary by source/tools/embed_shaders.cpp,
+//  which regenerates ShaderResources.h and EmbeddedShaderData.h:
+//
+//      embed_shaders shaders include
+//
+//  Embedded files are addressed as "embedded:<path under shaders/>",
+//  which ShaderPreprocessor resolves (includes too) without touching
+//  the file system. loadFromDisk() points the same IDs back at loose
+//  files for development, so edits and ShaderWatcher work as before.
+//
+
+#ifndef EmbeddedShaders_h
+#define EmbeddedShaders_h
+
+#include <cstddef>
+#include <string>
+
+struct EmbeddedFile
+{
+    const char * Path;   // relative to shaders/
+    const char * Data;
+    size_t       Size;
+};
+
+#include "ShaderResources.h"
+
+class EmbeddedShaders
+{
+public:
+    // Path Shader and ShaderPreprocessor use for a resource
+    static std::string path(ShaderResource resource);
+
+    static const EmbeddedFile& file(ShaderResource resource);
+
+    // Null unless path is an embedded path naming a known file
+    static const EmbeddedFile* find(const std::string& path);
+    static bool isEmbedded(const std::string& path);
+
+    // Collapses "." and ".." in embedded paths so relative includes find
+    // their target; disk paths are returned unchanged
+    static std::string normalize(const std::string& path);
+
+    // Development override: resolve resources under directory instead
+    static void loadFromDisk(const std::string& directory);
+    static void useEmbedded();
+    static bool isLoadingFromDisk();
+
+private:
+    static const char * const Prefix;
+};
+
+#endif
@@ -0,0 +1,50 @@
+//
+//  GLDeletionQueue.h
+//  Shaders
+//
+//  Created by Crunchy on 6/22/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  GL objects released during a frame are collected here and deleted
+//  together by flush() at frame end, one glDelete* call per kind,
+//  rather than stalling the driver mid-frame. Releasing is safe from
+//  any thread; flush() must run on the GL thread, and once more before
+//  the context goes away.
+//
+
+#ifndef GLDeletionQueue_h
+#define GLDeletionQueue_h
+
+#include <glad/3.3/glad.h>
+
+#include <mutex>
+#include <vector>
+
+class GLDeletionQueue
+{
+public:
+    // 0 is ignored, like glDelete* does
+    void deleteProgram(GLuint program);
+    void deleteBuffer(GLuint buffer);
+    void deleteVertexArray(GLuint vao);
+    void deleteTexture(GLuint texture);
+
+    // Issues the queued deletes. Returns the number of objects deleted.
+    size_t flush();
+
+    size_t pending() const;
+
+private:
+    mutable std::mutex  Lock;
+    std::vector<GLuint> Programs;
+    std::vector<GLuint> Buffers;
+    std::vector<GLuint> VertexArrays;
+    std::vector<GLuint> Textures;
+
+    void Queue(std::vector<GLuint>& queue, GLuint id);
+};
+
+// Paired with the single GL context, like GLState
+extern GLDeletionQueue GLDeletions;
+
+#endif
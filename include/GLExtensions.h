@@ -0,0 +1,70 @@
+//
+//  GLExtensions.h
+//  Shaders
+//
+//  Created by Crunchy on 6/4/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Entry points and enums beyond the glad 3.3 core loader. Each
+//  feature is optional: callers check the flag before using the
+//  matching function pointers.
+//
+
+#ifndef GLExtensions_h
+#define GLExtensions_h
+
+#include <glad/3.3/glad.h>
+
+// GL_ARB_get_program_binary (core in 4.1)
+/*---------------------------------*/
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#define GL_PROGRAM_BINARY_FORMATS          0x87FF
+#endif
+
+// GL_KHR_parallel_shader_compile
+/*---------------------------------*/
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+
+// GL_EXT_texture_compression_s3tc
+/*---------------------------------*/
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+
+struct GLExtensions
+{
+    // Features
+    bool HasProgramBinary = false;
+    bool HasParallelShaderCompile = false;
+    bool HasTextureCompressionS3TC = false;
+
+    // GL_ARB_get_program_binary
+    PFNGLEXTGETPROGRAMBINARYPROC  GetProgramBinary  = nullptr;
+    PFNGLEXTPROGRAMBINARYPROC     ProgramBinary     = nullptr;
+    PFNGLEXTPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+    // GL_KHR_parallel_shader_compile
+    PFNGLEXTMAXSHADERCOMPILERTHREADSPROC MaxShaderCompilerThreads = nullptr;
+};
+
+extern GLExtensions GLExt;
+
+// Call once after gladLoadGLLoader with the same loader
+void LoadGLExtensions(GLADloadproc load);
+bool HasGLExtension(const char * name);
+
+#endif
@@ -0,0 +1,105 @@
+//
+//  GLObject.h
+//  Shaders
+//
+//  Created by Crunchy on 6/22/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Move-only owners for GL object names. Destruction hands the name to
+//  GLDeletions, so the object is released at the next frame-end flush
+//  and never twice.
+//
+//      GLBuffer vbo = GLBuffer::create();
+//      GLState.bindBuffer(GL_ARRAY_BUFFER, vbo.id());
+//
+
+#ifndef GLObject_h
+#define GLObject_h
+
+#include <glad/3.3/glad.h>
+
+#include "GLDeletionQueue.h"
+
+#include <utility>
+
+// How each kind of object is made and released
+/*---------------------------------*/
+struct GLBufferKind
+{
+    static GLuint create()            { GLuint id = 0; glGenBuffers(1, &id); return id; }
+    static void   release(GLuint id)  { GLDeletions.deleteBuffer(id); }
+};
+
+struct GLVertexArrayKind
+{
+    static GLuint create()            { GLuint id = 0; glGenVertexArrays(1, &id); return id; }
+    static void   release(GLuint id)  { GLDeletions.deleteVertexArray(id); }
+};
+
+struct GLTextureKind
+{
+    static GLuint create()            { GLuint id = 0; glGenTextures(1, &id); return id; }
+    static void   release(GLuint id)  { GLDeletions.deleteTexture(id); }
+};
+
+struct GLProgramKind
+{
+    static GLuint create()            { return glCreateProgram(); }
+    static void   release(GLuint id)  { GLDeletions.deleteProgram(id); }
+};
+
+// Owner
+/*---------------------------------*/
+template <typename Kind>
+class GLObject
+{
+public:
+    GLObject() = default;
+
+    // Takes ownership of an existing name
+    explicit GLObject(GLuint id) : ID(id) {}
+
+    ~GLObject() { Kind::release(ID); }
+
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+
+    GLObject(GLObject&& other) noexcept : ID(other.ID) { other.ID = 0; }
+
+    GLObject& operator=(GLObject&& other) noexcept
+    {
+        if (this != &other)
+            reset(other.release());
+        return *this;
+    }
+
+    static GLObject create() { return GLObject(Kind::create()); }
+
+    GLuint id() const                { return ID; }
+    explicit operator bool() const   { return ID != 0; }
+
+    // Queues the current name for deletion and owns id instead
+    void reset(GLuint id = 0)
+    {
+        Kind::release(ID);
+        ID = id;
+    }
+
+    // Gives up ownership without deleting
+    GLuint release()
+    {
+        GLuint id = ID;
+        ID = 0;
+        return id;
+    }
+
+private:
+    GLuint ID = 0;
+};
+
+typedef GLObject<GLBufferKind>      GLBuffer;
+typedef GLObject<GLVertexArrayKind> GLVertexArray;
+typedef GLObject<GLTextureKind>     GLTexture;
+typedef GLObject<GLProgramKind>     GLProgram;
+
+#endif
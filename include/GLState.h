@@ -0,0 +1,94 @@
+//
+//  GLState.h
+//  Shaders
+//
+//  Created by Crunchy on 6/16/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Shadow copy of the GL bindings and fixed-function state we touch
+//  every frame. Calls that would not change anything are dropped
+//  before they reach the driver. Anything that changes state behind
+//  the cache's back must call invalidate() afterwards.
+//
+
+#ifndef GLState_h
+#define GLState_h
+
+#include <glad/3.3/glad.h>
+
+struct GLStateCounters
+{
+    unsigned int Issued   = 0;  // calls forwarded to GL
+    unsigned int Filtered = 0;  // redundant calls dropped
+};
+
+class GLStateCache
+{
+public:
+    GLStateCache();
+
+    // Bindings
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void activeTexture(GLenum unit);
+    void bindTexture(GLenum target, GLuint texture);
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    // Fixed-function state
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void blendFunc(GLenum source, GLenum destination);
+    void depthFunc(GLenum function);
+    void depthMask(GLboolean write);
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // GL unbinds deleted objects; keep the shadow copy in step
+    void onDeleteProgram(GLuint program);
+    void onDeleteVertexArray(GLuint vao);
+    void onDeleteBuffer(GLuint buffer);
+    void onDeleteTexture(GLuint texture);
+
+    // Forget everything; the next call of each kind is always issued
+    void invalidate();
+
+    // Counters
+    void beginFrame();
+    const GLStateCounters& frame() const    { return Frame; }
+    const GLStateCounters& previous() const { return Previous; }
+
+private:
+    static const GLuint UNKNOWN         = 0xFFFFFFFFu;
+    static const int    TEXTURE_UNITS   = 32;
+    static const int    TEXTURE_TARGETS = 3;   // 2D, 2D array, cube map
+
+    GLuint Program;
+    GLuint VertexArray;
+    GLuint ArrayBuffer;
+    GLuint ElementBuffer;       // VAO state: unknown after every VAO change
+    GLuint UniformBlockBuffer;
+    GLuint PixelUnpackBuffer;
+    GLuint ActiveUnit;
+    GLuint Textures[TEXTURE_UNITS][TEXTURE_TARGETS];
+
+    GLuint Blend;
+    GLuint DepthTest;
+    GLuint CullFace;
+    GLenum BlendSource, BlendDestination;
+    GLenum DepthFunction;
+    GLuint DepthWrite;
+    GLint  Viewport[4];
+
+    GLStateCounters Frame;
+    GLStateCounters Previous;
+
+    bool    Changed(GLuint& cached, GLuint value);
+    GLuint* BufferSlot(GLenum target);
+    GLuint* CapabilitySlot(GLenum capability);
+    static int TargetIndex(GLenum target);
+};
+
+// One GL context per process, so one cache
+extern GLStateCache GLState;
+
+#endif
@@ -0,0 +1,49 @@
+//
+//  Hash.h
+//  Shaders
+//
+//  Created by Crunchy on 6/4/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#ifndef Hash_h
+#define Hash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a. Pass a previous result as seed to hash several
+// pieces of data as one stream.
+const uint64_t FNV64_OFFSET = 14695981039346656037ull;
+const uint64_t FNV64_PRIME  = 1099511628211ull;
+
+inline uint64_t HashBytes(const void * data, size_t length, uint64_t seed = FNV64_OFFSET)
+{
+    const unsigned char * bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t HashString(const std::string& text, uint64_t seed = FNV64_OFFSET)
+{
+    // Length first so ("ab","c") and ("a","bc") differ
+    const uint64_t length = text.size();
+    return HashBytes(text.data(), text.size(), HashBytes(&length, sizeof(length), seed));
+}
+
+inline std::string HashToHex(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4)
+        hex[i] = digits[hash & 0xF];
+    return hex;
+}
+
+#endif
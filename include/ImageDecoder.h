@@ -0,0 +1,124 @@
+//
+//  ImageDecoder.h
+//  Shaders
+//
+//  Created by Crunchy on 7/17/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  stb_image decoding with the flip and channel count given per call
+//  instead of through stbi_set_flip_vertically_on_load, whose global
+//  makes two workers with different settings race. Safe to call from
+//  any number of threads at once: stbi always decodes unflipped, in the
+//  file's own channels, and failure reasons are thread local.
+//
+//  The flip and the channel conversion happen while the rows are
+//  written out, in one pass, rather than as stbi's separate conversion
+//  and flip passes over the whole image. Write straight into the
+//  destination (a mapped pixel buffer, an atlas page) and the decode
+//  costs no pass of its own at all.
+//
+//  JPEG is the exception: stbi converts channels as part of its colour
+//  conversion, for free, so there only the flip is left to the copy.
+//  Conversions match stbi_load's either way. Decoding sets stbi's
+//  per-thread flip, so a plain stbi_load later on the same thread must
+//  use stbi_set_flip_vertically_on_load_thread, not the global.
+//
+//  Radiance (.hdr) images go through decodeHalf instead: stbi_loadf's
+//  linear floats, converted to half floats (and flipped) row by row,
+//  across a ThreadPool if given one, for GL_HALF_FLOAT uploads.
+//
+
+#ifndef ImageDecoder_h
+#define ImageDecoder_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct ImageDecodeOptions
+{
+    bool FlipVertically = false;    // bottom row first, the way GL takes them
+    int  Channels       = 0;        // 1 to 4, or 0 for the file's own
+    bool ExpandRGB      = false;    // with 0 Channels, RGB files come out RGBA
+};
+
+class DecodedPixels
+{
+public:
+    DecodedPixels() = default;
+
+    bool isValid() const               { return Source != nullptr; }
+    const std::string& error() const   { return Error; }
+
+    int width() const          { return Width; }
+    int height() const         { return Height; }
+    int channels() const       { return Channels; }         // as requested
+    int fileChannels() const   { return FileChannels; }     // as stbi decoded them
+
+    size_t rowBytes() const { return (size_t)Width * Channels; }
+    size_t size() const     { return rowBytes() * Height; }
+
+    // The one output pass: rows in the requested order and channel
+    // count. Stride 0 packs them.
+    void writeRows(unsigned char * destination, size_t stride = 0) const;
+
+    // The same, in place (or into a buffer of its own when the channel
+    // count changes), for callers that want the pixels where they are.
+    // Valid for the object's lifetime.
+    const unsigned char * data();
+
+private:
+    friend class ImageDecoder;
+
+    struct StbiDeleter
+    {
+        void operator()(unsigned char * pixels) const;
+    };
+
+    std::unique_ptr<unsigned char, StbiDeleter> Source;   // unflipped, FileChannels
+    std::vector<unsigned char> Converted;
+    const unsigned char * Output = nullptr;                // once data() has run
+    int  Width        = 0;
+    int  Height       = 0;
+    int  Channels     = 0;
+    int  FileChannels = 0;
+    bool Flip         = false;
+    std::string Error;
+};
+
+// Rows already in the requested order, packed
+struct HalfPixels
+{
+    std::vector<uint16_t> Data;
+    int Width    = 0;
+    int Height   = 0;
+    int Channels = 0;
+    std::string Error;
+
+    bool isValid() const   { return !Data.empty(); }
+    size_t rowBytes() const { return (size_t)Width * Channels * sizeof(uint16_t); }
+    size_t size() const     { return Data.size() * sizeof(uint16_t); }
+};
+
+class ImageDecoder
+{
+public:
+    static DecodedPixels decode(const void * data, size_t size, const ImageDecodeOptions& options = ImageDecodeOptions());
+
+    // Maps the file, so nothing is read twice
+    static DecodedPixels decodeFile(const std::string& path, const ImageDecodeOptions& options = ImageDecodeOptions());
+
+    // Whether the data is a Radiance image, for which decodeHalf is the way
+    static bool isHdr(const void * data, size_t size);
+
+    // Any image stbi reads, as half floats: HDR values as they are, 8-bit
+    // ones scaled to 0 to 1 with stbi's gamma undone
+    static HalfPixels decodeHalf(const void * data, size_t size, const ImageDecodeOptions& options = ImageDecodeOptions(),
+                                 ThreadPool * pool = nullptr);
+};
+
+#endif
@@ -0,0 +1,44 @@
+//
+//  MappedFile.h
+//  Shaders
+//
+//  Created by Crunchy on 6/18/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Read-only memory mapping of a whole file: one open, one fstat,
+//  one mmap, no copies. The mapping lives as long as the object.
+//
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool isOpen() const              { return Open; }
+    const char * data() const        { return Data; }
+    size_t size() const              { return Size; }
+    const std::string& error() const { return Error; }
+
+private:
+    const char * Data = nullptr;
+    size_t       Size = 0;
+    bool         Open = false;
+    std::string  Error;
+
+    void Release();
+};
+
+#endif
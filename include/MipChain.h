@@ -0,0 +1,55 @@
+//
+//  MipChain.h
+//  Shaders
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  CPU mip generation for the texture baker, so the runtime uploads
+//  every level instead of calling glGenerateMipmap. Colour channels
+//  are filtered in linear light (sRGB decoded through
+//  glm/gtc/color_space.hpp and encoded again per level); alpha is
+//  filtered as it is. Each level is filtered from the float level
+//  above, one RGBA texel per SSE2 register, with rows split across a
+//  ThreadPool; the conversion back to 8 bits runs across the rows of
+//  every level at once.
+//
+
+#ifndef MipChain_h
+#define MipChain_h
+
+#include "TextureContainer.h"
+
+#include <vector>
+
+class ThreadPool;
+
+struct MipImage
+{
+    int Width    = 0;
+    int Height   = 0;
+    int Channels = 0;
+    std::vector<unsigned char> Pixels;  // packed rows
+
+    TextureLevel level() const;
+};
+
+enum class MipFilter
+{
+    Box,        // 2x2 average
+    Kaiser,     // Kaiser windowed sinc over 12 taps; sharper, may ring
+};
+
+struct MipOptions
+{
+    MipFilter    Filter = MipFilter::Box;
+    bool         Srgb   = true;     // colour channels are sRGB encoded
+    ThreadPool * Pool   = nullptr;  // or run on the calling thread
+};
+
+// Level 0 (a copy of the input) down to 1x1, each level half the one
+// above rounded down. Odd edges repeat their last texel.
+std::vector<MipImage> GenerateMipChain(const unsigned char * pixels, int width, int height, int channels,
+                                       const MipOptions& options = MipOptions());
+
+#endif
@@ -0,0 +1,58 @@
+//
+//  PixelUpload.h
+//  Shaders
+//
+//  Created by Crunchy on 7/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  What glTexImage2D needs to know about packed 8-bit images of 1 to 4
+//  channels: the formats for the channel count, and an unpack
+//  alignment that matches how the rows are really laid out. GL's
+//  default of 4 is wrong for most RGB and grey widths, and 1 is right
+//  for all of them but sends drivers down their byte-at-a-time path.
+//
+//  RGB rows are the slow case even when aligned, since the driver
+//  pads every texel to four bytes itself. ExpandRGBToRGBA does that
+//  padding up front, 16 texels per shuffle (SSSE3 or NEON), so the
+//  upload is a plain RGBA copy. x86 builds without -mssse3 pick the
+//  shuffle at run time.
+//
+//  HDR images go up as half floats: half the memory and bandwidth of
+//  GL_RGB32F, and range enough for radiance. FloatToHalf converts
+//  eight values a step.
+//
+
+#ifndef PixelUpload_h
+#define PixelUpload_h
+
+#include <glad/3.3/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct PixelFormat
+{
+    GLint  Internal;
+    GLenum Format;                      // 0 for compressed formats
+    GLenum Type = GL_UNSIGNED_BYTE;
+};
+
+// GL_R8/GL_RED, GL_RG8/GL_RG, GL_RGB8/GL_RGB or GL_RGBA8/GL_RGBA
+PixelFormat PixelFormatFor(int channels);
+
+// GL_R16F to GL_RGBA16F, from GL_HALF_FLOAT
+PixelFormat HalfFormatFor(int channels);
+
+// The largest of 8, 4, 2 and 1 that every row start meets, given rows
+// of `rowBytes` from `address` (a pointer, or an offset into a bound
+// GL_PIXEL_UNPACK_BUFFER)
+GLint UnpackAlignmentFor(size_t rowBytes, uintptr_t address = 0);
+
+// Alpha 255. The buffers must not overlap.
+void ExpandRGBToRGBA(const unsigned char * rgb, unsigned char * rgba, size_t texels);
+
+// glm::packHalf1x16 of every value. The SSE2 kernel matches it bit for
+// bit; NEON's conversion rounds ties to even instead of away from zero.
+void FloatToHalf(const float * values, uint16_t * halves, size_t count);
+
+#endif
@@ -0,0 +1,62 @@
+//
+//  ProgramCache.h
+//  Shaders
+//
+//  Created by Crunchy on 6/4/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  On-disk cache of linked program binaries. Entries are keyed by
+//  the shader sources, the defines and the driver strings, so a new
+//  driver or an edited shader simply misses and recompiles.
+//
+
+#ifndef ProgramCache_h
+#define ProgramCache_h
+
+#include <glad/3.3/glad.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+struct ProgramCacheStats
+{
+    unsigned int Hits     = 0;
+    unsigned int Misses   = 0;
+    unsigned int Rejected = 0;  // present on disk but stale or corrupt
+    unsigned int Stored   = 0;
+
+    double LoadMs    = 0.0;     // time spent in glProgramBinary on hits
+    double CompileMs = 0.0;     // time spent compiling on misses
+    double SavedMs   = 0.0;     // recorded compile time minus load time, over all hits
+};
+
+class ProgramCache
+{
+public:
+    // Requires LoadGLExtensions() to have found program binary support
+    static bool enable(const std::string& directory);
+    static void disable();
+    static bool isEnabled();
+
+    // Stage hashes are of the fully expanded sources
+    static uint64_t makeKey(uint64_t vertexHash,
+                            uint64_t fragmentHash,
+                            const std::string& defines);
+
+    // Returns a linked program, or 0 on a miss
+    static GLuint load(uint64_t key);
+
+    // Program must have been linked with the retrievable hint set
+    static void store(uint64_t key, GLuint program, double compileMs);
+
+    static void markRetrievable(GLuint program);
+
+    static const ProgramCacheStats& stats();
+    static void printStats(std::ostream& out);
+
+private:
+    static std::string EntryPath(uint64_t key);
+};
+
+#endif
@@ -9,35 +9,138 @@
 #ifndef Shader_h
 #define Shader_h
 
+#include <glad/3.3/glad.h>
+
 #include <cstdio>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+
+#include "EmbeddedShaders.h"
+#include "ShaderPreprocessor.h"
+#include "UniformTable.h"
+#include "UniformUpload.h"
+
+class ShaderWatcher;
 
 class Shader
 {
+    friend class ShaderLibrary;
+    friend class ShaderWatcher;
+    
 public:
-    Shader(const char * vertexPath, const char * fragmentPath);
+    Shader(const char * vertexPath, const char * fragmentPath,
+           const std::vector<std::string>& defines = std::vector<std::string>());
+
+    // Built into the binary; reads no files unless EmbeddedShaders::loadFromDisk
+    Shader(ShaderResource vertex, ShaderResource fragment,
+           const std::vector<std::string>& defines = std::vector<std::string>());
+
+    // Owns its program: move-only, released through GLDeletions. A
+    // watched shader stays watched at its new address when moved, and
+    // is unwatched when destroyed.
+    ~Shader();
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    Shader(Shader&& other) noexcept;
+    Shader& operator=(Shader&& other) noexcept;
     
     // Variables
-    unsigned int ID;
+    unsigned int ID = 0;
+    unsigned int Revision = 0;  // bumped on every successful reload
     
     // Methods
     void use();
 
+    // Replaces the program only if the new sources link; on failure the
+    // previous program stays in use. Handles must be re-resolved once
+    // Revision changes.
+    bool reload(const PreprocessedSource& vertex, const PreprocessedSource& fragment);
+
+    const std::string& vertexPath() const   { return VertexPath; }
+    const std::string& fragmentPath() const { return FragmentPath; }
+    const std::vector<std::string>& defines() const { return Defines; }
+
+    // Maps both stages with #include and the defines expanded. Files
+    // receives every file the program depends on. Sources kept for
+    // later (ShaderWatcher) should be SourceFiles::Copied.
+    bool loadSources(PreprocessedSource& vertex, PreprocessedSource& fragment,
+                     std::vector<std::string>* files = nullptr,
+                     SourceFiles access = SourceFiles::Mapped) const;
+
+    // Uniform Lookup (resolved at link time, no driver round-trip)
+    UniformHandle getUniform(const std::string& name) const;
+    UniformHandle getUniform(uint32_t nameHash) const;
+
     // Set Primitive
     void setBool (const std::string& name, bool value)  const;
     void setInt  (const std::string& name, int value)   const;
     void setFloat(const std::string& name, float value) const;
 
+    void setBool (UniformHandle uniform, bool value)  const;
+    void setInt  (UniformHandle uniform, int value)   const;
+    void setFloat(UniformHandle uniform, float value) const;
+
     // Set Vector
+    void setVec2(const std::string& name, const glm::vec2& value) const;
+    void setVec3(const std::string& name, const glm::vec3& value) const;
+    void setVec4(const std::string& name, const glm::vec4& value) const;
+
+    void setVec2(UniformHandle uniform, const glm::vec2& value) const;
+    void setVec3(UniformHandle uniform, const glm::vec3& value) const;
+    void setVec4(UniformHandle uniform, const glm::vec4& value) const;
 
     // Set Matrix
+    void setMat3(const std::string& name, const glm::mat3& value) const;
+    void setMat4(const std::string& name, const glm::mat4& value) const;
+
+    void setMat3(UniformHandle uniform, const glm::mat3& value) const;
+    void setMat4(UniformHandle uniform, const glm::mat4& value) const;
+
+    // Set Array (one glUniform*v call of count N, e.g. bone palettes, lights)
+    template <typename T>
+    void setArray(UniformHandle uniform, const T * values, GLsizei count) const
+    {
+        // Nothing to send, and the glm uploads would dereference values
+        if (count <= 0)
+            return;
+        UniformUpload<T>::upload(uniform.Location, count, values);
+    }
+
+    template <typename T>
+    void setArray(UniformHandle uniform, const std::vector<T>& values) const
+    {
+        setArray(uniform, values.data(), (GLsizei)values.size());
+    }
+
+    template <typename T>
+    void setArray(const std::string& name, const T * values, GLsizei count) const
+    {
+        setArray(Uniforms.find(name), values, count);
+    }
+
+    template <typename T>
+    void setArray(const std::string& name, const std::vector<T>& values) const
+    {
+        setArray(Uniforms.find(name), values.data(), (GLsizei)values.size());
+    }
     
 private:
-    bool FileExists(const std::string& path);
-    void CheckCompileErrors(GLuint shader, const std::string& type);
+    // Adopts an already linked program (see ShaderLibrary)
+    Shader(GLuint program, const std::string& vertexPath, const std::string& fragmentPath,
+           const std::vector<std::string>& defines);
+    
+    std::string  VertexPath;
+    std::string  FragmentPath;
+    std::vector<std::string> Defines;
+    UniformTable Uniforms;
+    ShaderWatcher* Watcher = nullptr;   // set by ShaderWatcher::watch
+
+    void OnLinked();
+    GLuint CreateProgram(const PreprocessedSource& vertex, const PreprocessedSource& fragment);
+    static bool CheckCompileErrors(GLuint shader, const std::string& type);
 };
 
 #endif
@@ -0,0 +1,119 @@
+//
+//  ShaderLibrary.h
+//  Shaders
+//
+//  Created by Crunchy on 6/8/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Batched program creation. All compiles and links for a batch are
+//  issued before any status is read back, so the driver can overlap
+//  them (GL_KHR_parallel_shader_compile) instead of blocking on each
+//  program in turn the way the Shader constructor does.
+//
+//  Sources are expanded (#include, #define) first and deduplicated by
+//  content hash: identical stages compile once, and names whose
+//  expanded program is identical share one Shader.
+//
+
+#ifndef ShaderLibrary_h
+#define ShaderLibrary_h
+
+#include "Shader.h"
+#include "ShaderProfiler.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+struct ProgramDesc
+{
+    std::string Name;
+    std::string VertexPath;
+    std::string FragmentPath;
+    std::vector<std::string> Defines;
+};
+
+struct ShaderLibraryStats
+{
+    unsigned int Requested      = 0;    // programs submitted by name
+    unsigned int ProgramsLinked = 0;    // unique programs actually linked
+    unsigned int ProgramReuses  = 0;    // names resolved to an existing program
+    unsigned int StageCompiles  = 0;    // glCompileShader calls issued
+    unsigned int StageReuses    = 0;    // stages shared with another program
+};
+
+class ShaderLibrary
+{
+public:
+    ShaderLibrary();
+    ~ShaderLibrary();
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    // Queue programs for the next submit()
+    void add(const ProgramDesc& desc);
+    void add(const std::vector<ProgramDesc>& descs);
+
+    // Queues one program per define set, named "<base>+A+B"
+    // ("<base>" for an empty set)
+    void addPermutations(const ProgramDesc& base, const std::vector<std::vector<std::string>>& defineSets);
+
+    // Issues every compile and link without waiting on any of them
+    void submit();
+
+    // True once the driver reports every submitted program complete.
+    // Always true without GL_KHR_parallel_shader_compile.
+    bool isReady() const;
+
+    // Blocks until ready, checks status and publishes the programs.
+    // Returns the number of names whose program failed.
+    int finish();
+
+    // submit() + finish()
+    int compile();
+
+    // Null until finish() has published the program. Pointers stay
+    // valid for the library's lifetime, or until a finish() that
+    // publishes new sources under every name sharing the program.
+    Shader* get(const std::string& name) const;
+
+    size_t size() const { return Programs.size(); }
+    size_t uniqueCount() const { return Unique.size(); }
+
+    const ShaderLibraryStats& stats() const { return Stats; }
+    void printStats(std::ostream& out) const;
+
+    static std::string permutationName(const std::string& base, const std::vector<std::string>& defines);
+
+private:
+    struct PendingProgram
+    {
+        ProgramDesc Desc;               // first name that asked for this program
+        uint64_t    Content  = 0;       // hash of both expanded stages
+        uint64_t    Key      = 0;
+        GLuint      Vertex   = 0;
+        GLuint      Fragment = 0;
+        GLuint      Program  = 0;
+        bool        Cached   = false;   // loaded from ProgramCache, nothing to wait for
+        ShaderTiming Timing;
+    };
+
+    std::vector<ProgramDesc>    Queued;
+    std::vector<PendingProgram> Pending;
+    std::vector<GLuint>         Stages;                 // pending, deduplicated shader objects
+    std::map<std::string, uint64_t> PendingNames;       // name -> content hash
+    std::set<std::string>       UnreadNames;            // submitted names whose sources failed to expand
+
+    std::map<uint64_t, std::unique_ptr<Shader>> Unique; // content hash -> program
+    std::map<std::string, Shader*> Programs;
+
+    ShaderLibraryStats Stats;
+    double SubmitMs = 0.0;
+
+    bool IsComplete(const PendingProgram& pending) const;
+};
+
+#endif
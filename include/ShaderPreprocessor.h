@@ -0,0 +1,94 @@
+//
+//  ShaderPreprocessor.h
+//  Shaders
+//
+//  Created by Crunchy on 6/10/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Expands #include "file" (relative to the including file, each file
+//  at most once) and injects a set of #defines right after #version.
+//  #line directives keep compiler errors pointing at the right line;
+//  the source-string number indexes Files.
+//
+//  Files are memory mapped (or read from the embedded copy, see
+//  EmbeddedShaders.h) and never copied: the result is a list of spans
+//  plus the few generated lines, ready to be handed to glShaderSource
+//  as-is. Sources that must outlive edits to their files (hot-reload
+//  reads them long before the GL thread compiles) ask for
+//  SourceFiles::Copied instead, which reads each file into Generated.
+//
+
+#ifndef ShaderPreprocessor_h
+#define ShaderPreprocessor_h
+
+#include <glad/3.3/glad.h>
+
+#include "Hash.h"
+#include "MappedFile.h"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class SourceFiles
+{
+    Mapped,     // spans point into the files themselves
+    Copied,     // files read into owned strings
+};
+
+// Move-only: Strings point into Mappings and Generated
+struct PreprocessedSource
+{
+    PreprocessedSource() = default;
+    PreprocessedSource(PreprocessedSource&&) = default;
+    PreprocessedSource& operator=(PreprocessedSource&&) = default;
+    PreprocessedSource(const PreprocessedSource&) = delete;
+    PreprocessedSource& operator=(const PreprocessedSource&) = delete;
+
+    std::vector<const GLchar *> Strings;
+    std::vector<GLint>          Lengths;
+    std::vector<std::string>    Files;   // Files[0] is the root file
+
+    std::vector<std::unique_ptr<MappedFile>> Mappings;
+    std::list<std::string>                   Generated;   // list: elements never move
+
+    // Filled by ShaderPreprocessor::expand, for ShaderProfiler
+    double ReadMs       = 0.0;   // opening and mapping files
+    double PreprocessMs = 0.0;   // everything else
+
+    // Hash of the expanded text, equal to hashing code()
+    uint64_t hash(uint64_t seed = FNV64_OFFSET) const;
+
+    // Concatenated copy, for logging and tools
+    std::string code() const;
+
+    void clear();
+    void append(const char * text, size_t length);
+    void append(std::string text);
+};
+
+class ShaderPreprocessor
+{
+public:
+    // Defines are "NAME" or "NAME VALUE" ("NAME=VALUE" is accepted too)
+    static bool expand(const std::string& path,
+                       const std::vector<std::string>& defines,
+                       PreprocessedSource& result,
+                       SourceFiles files = SourceFiles::Mapped);
+
+    // Canonical "A;B=1;C" form, used for cache keys and permutation names
+    static std::string joinDefines(const std::vector<std::string>& defines, char separator = ';');
+
+private:
+    static bool ExpandFile(const std::string& path,
+                           const std::vector<std::string>& defines,
+                           std::vector<std::string>& stack,
+                           SourceFiles files,
+                           PreprocessedSource& result);
+
+    static std::string DirectoryOf(const std::string& path);
+    static bool ReadFile(const std::string& path, std::string& text, std::string& error);
+};
+
+#endif
@@ -0,0 +1,66 @@
+//
+//  ShaderProfiler.h
+//  Shaders
+//
+//  Created by Crunchy on 6/24/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Where the time goes when a program is built: file reads, #include
+//  expansion, each stage's compile, the link and the program binary
+//  cache. Shader and ShaderLibrary record one entry per program they
+//  build (reloads included).
+//
+//  Compile and link times include the status query that follows them,
+//  which is what forces a driver that compiles lazily to finish.
+//
+
+#ifndef ShaderProfiler_h
+#define ShaderProfiler_h
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ShaderTiming
+{
+    std::string VertexPath;
+    std::string FragmentPath;
+    std::string Defines;            // joined, see ShaderPreprocessor::joinDefines
+
+    double ReadMs            = 0.0; // open + map, both stages and includes
+    double PreprocessMs      = 0.0; // #include / #define expansion
+    double CacheMs           = 0.0; // ProgramCache lookup, hit or miss
+    double VertexCompileMs   = 0.0;
+    double FragmentCompileMs = 0.0;
+    double LinkMs            = 0.0;
+
+    bool CacheHit = false;
+    bool Linked   = false;
+    bool Reload   = false;
+    bool Batched  = false;          // ShaderLibrary: compile + link is the batch average, in LinkMs
+
+    double totalMs() const
+    {
+        return ReadMs + PreprocessMs + CacheMs + VertexCompileMs + FragmentCompileMs + LinkMs;
+    }
+};
+
+class ShaderProfiler
+{
+public:
+    // On by default; recording is a few clock reads per program
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void record(const ShaderTiming& timing);
+    static const std::vector<ShaderTiming>& timings();
+    static void clear();
+
+    // Slowest first; count limits the rows (0 for all)
+    static void printReport(std::ostream& out, size_t count = 0);
+
+    static void writeJson(std::ostream& out);
+    static bool writeJson(const std::string& path);
+};
+
+#endif
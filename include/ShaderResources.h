@@ -0,0 +1,27 @@
+//
+//  ShaderResources.h
+//  Shaders
+//
+//  Generated by source/tools/embed_shaders.cpp. Do not edit.
+//
+
+#ifndef ShaderResources_h
+#define ShaderResources_h
+
+#include <cstddef>
+
+enum class ShaderResource : size_t
+{
+    fragment_base_fs,
+    fragment_base_texture_fs,
+    fragment_blend_texture2_array_fs,
+    fragment_blend_texture2_fs,
+    fragment_texture_fs,
+    include_texture_inputs_glsl,
+    vertex_base_array_vs,
+    vertex_base_vs,
+};
+
+const size_t SHADER_RESOURCE_COUNT = 8;
+
+#endif
@@ -0,0 +1,85 @@
+//
+//  ShaderWatcher.h
+//  Shaders
+//
+//  Created by Crunchy on 6/6/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Hot-reload for Shader programs. A background thread waits for
+//  shader files (or anything they #include) to change (inotify on Linux, mtime polling elsewhere)
+//  and reads the new sources; the GL thread calls poll() once per
+//  frame to compile, link and swap whatever is ready.
+//
+
+#ifndef ShaderWatcher_h
+#define ShaderWatcher_h
+
+#include "Shader.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ShaderWatcher
+{
+public:
+    ShaderWatcher();
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // GL thread. A watched shader stays watched when moved and unwatches
+    // itself when destroyed; shaders and watcher may die in either order.
+    void watch(Shader& shader);
+    void unwatch(Shader& shader);
+
+    void start();
+    void stop();
+
+    // GL thread only. Returns the number of programs swapped in.
+    int poll();
+
+private:
+    friend class Shader;
+
+    struct PendingReload
+    {
+        Shader*            Target;
+        PreprocessedSource Vertex;
+        PreprocessedSource Fragment;
+    };
+
+    // The watcher's own copy of what it needs to re-read a shader, taken
+    // in watch(). The worker never touches a Shader's members, which the
+    // GL thread may be moving or destroying.
+    struct WatchedShader
+    {
+        std::string              VertexPath;
+        std::string              FragmentPath;
+        std::vector<std::string> Defines;
+        std::vector<std::string> Dependencies;   // resolved paths of every file (includes too) it reads
+    };
+
+    std::thread       Worker;
+    std::atomic<bool> Running;
+
+    std::mutex                       Lock;
+    std::map<Shader*, WatchedShader> Shaders;   // guarded by Lock
+    std::vector<PendingReload>       Pending;   // guarded by Lock
+
+    // Called by Shader's moves
+    void Moved(Shader& from, Shader& to);
+
+    void Run();
+    void QueueReloads(const std::vector<std::string>& changedPaths);
+
+    static std::vector<std::string> ResolvePaths(const std::vector<std::string>& paths);
+    static std::string ResolvePath(const std::string& path);
+    static std::string DirectoryOf(const std::string& path);
+};
+
+#endif
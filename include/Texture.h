@@ -0,0 +1,95 @@
+//
+//  Texture.h
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  A 2D texture that may still be loading. Until the image arrives,
+//  id() is the loader's placeholder, so draw code binds it every frame
+//  without caring whether it is ready.
+//
+
+#ifndef Texture_h
+#define Texture_h
+
+#include <glad/3.3/glad.h>
+
+#include "GLObject.h"
+#include "GLState.h"
+
+#include <string>
+
+struct TextureParams
+{
+    GLint WrapS     = GL_REPEAT;
+    GLint WrapT     = GL_REPEAT;
+    GLint MinFilter = GL_LINEAR_MIPMAP_LINEAR;
+    GLint MagFilter = GL_LINEAR;
+    bool  Mipmaps   = true;
+
+    // Image rows are stored top first, GL expects the bottom row first
+    bool  FlipVertically = true;
+
+    // Upload 8-bit RGB images as RGBA. Drivers pad RGB8 to four bytes a
+    // texel anyway, so this moves that work off the GL thread for free.
+    // HDR images stay RGB16F.
+    bool  ExpandRGB = true;
+
+    // Upload the small mips first and the larger ones over later frames,
+    // within the loader's stream budget. 8-bit images get their chain
+    // built on the worker, baked textures stream the levels they carry;
+    // HDR images load whole.
+    bool  Stream = false;
+};
+
+class Texture
+{
+    friend class TextureLoader;
+
+public:
+    GLuint id() const { return Ready ? Object.id() : Placeholder; }
+
+    // Binds id() to the given unit through the state cache
+    void bind(GLuint unit) const { GLState.bindTexture(unit, GL_TEXTURE_2D, id()); }
+
+    bool isReady() const   { return Ready; }
+    bool hasFailed() const { return Failed; }
+
+    const std::string& path() const     { return Path; }
+    const TextureParams& params() const { return Params; }
+    int width() const    { return Width; }
+    int height() const   { return Height; }
+    int channels() const { return Channels; }
+
+    // GL_TEXTURE_BASE_LEVEL: the largest level uploaded so far, 0 once
+    // streaming is done
+    int baseLevel() const { return BaseLevel; }
+
+    // Longest side, in pixels, the texture covers on screen. Streaming
+    // textures get their detail largest first; set it each frame.
+    void setScreenSize(float pixels) { ScreenSize = pixels; }
+    float screenSize() const         { return ScreenSize; }
+
+    // Estimated video memory, mip chain included; 0 until ready
+    size_t gpuBytes() const { return Bytes; }
+
+private:
+    Texture(const std::string& path, const TextureParams& params, GLuint placeholder)
+        : Path(path), Params(params), Placeholder(placeholder) {}
+
+    std::string   Path;
+    TextureParams Params;
+    GLTexture     Object;
+    GLuint        Placeholder = 0;
+    int           Width       = 0;
+    int           Height      = 0;
+    int           Channels    = 0;
+    int           BaseLevel   = 0;
+    float         ScreenSize  = 0.0f;
+    size_t        Bytes       = 0;
+    bool          Ready       = false;
+    bool          Failed      = false;
+};
+
+#endif
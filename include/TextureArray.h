@@ -0,0 +1,115 @@
+//
+//  TextureArray.h
+//  Shaders
+//
+//  Created by Crunchy on 7/15/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Groups images of the same size and channel count into the layers of
+//  GL_TEXTURE_2D_ARRAY textures, so every material in a group draws from
+//  one bind and picks its images by layer index: per draw through a
+//  uniform, or per vertex or instance through an attribute (see
+//  vertex/base.array.vs and fragment/blend.texture2.array.fs).
+//
+//  Unlike a TextureAtlas, layers never bleed into one another: each
+//  keeps a full mip chain and can wrap (GL_REPEAT).
+//
+
+#ifndef TextureArray_h
+#define TextureArray_h
+
+#include <glad/3.3/glad.h>
+
+#include "GLObject.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Where one image ended up
+struct ArrayLayer
+{
+    size_t Group = 0;
+    int    Layer = 0;
+};
+
+struct TextureArrayOptions
+{
+    // GL_MAX_ARRAY_TEXTURE_LAYERS is at least 256 in 3.3. Larger values
+    // must stay within TextureArrays::maxLayers(); upload() refuses
+    // groups that don't.
+    int   MaxLayers = 256;
+    bool  Mipmaps   = true;
+    GLint Wrap      = GL_REPEAT;
+};
+
+class TextureArrays
+{
+public:
+    size_t groupCount() const { return Groups.size(); }
+    int width(size_t group) const      { return Groups[group].Width; }
+    int height(size_t group) const     { return Groups[group].Height; }
+    int channels(size_t group) const   { return Groups[group].Channels; }
+    int layerCount(size_t group) const { return Groups[group].Layers; }
+
+    const ArrayLayer * find(const std::string& name) const;
+
+    // GL thread. Creates one array texture per group; the pixels are
+    // released once uploaded, so only the first call does anything.
+    void upload();
+    bool isUploaded() const { return !Textures.empty(); }
+
+    // GL thread. The driver's GL_MAX_ARRAY_TEXTURE_LAYERS.
+    static int maxLayers();
+
+    GLuint texture(size_t group) const { return Textures[group].id(); }
+    void bind(size_t group, GLuint unit) const;
+
+private:
+    friend class TextureArrayBuilder;
+
+    struct Group
+    {
+        int Width    = 0;
+        int Height   = 0;
+        int Channels = 0;
+        int Layers   = 0;
+        std::vector<unsigned char> Pixels;  // layer after layer
+    };
+
+    TextureArrayOptions Options;
+    std::vector<Group> Groups;
+    std::vector<GLTexture> Textures;
+    std::unordered_map<std::string, ArrayLayer> Layers;
+};
+
+class TextureArrayBuilder
+{
+public:
+    explicit TextureArrayBuilder(const TextureArrayOptions& options = TextureArrayOptions());
+
+    // Rows in upload order (bottom first), 1 to 4 channels
+    void add(const std::string& name, const unsigned char * pixels, int width, int height, int channels);
+
+    // Decodes through ImageDecoder, flipped; the name is the path
+    bool addFile(const std::string& path);
+
+    // Groups by size and channel count, in the order added; a group
+    // past MaxLayers continues in another array
+    TextureArrays build() const;
+
+private:
+    struct Image
+    {
+        std::string Name;
+        int Width    = 0;
+        int Height   = 0;
+        int Channels = 0;
+        std::vector<unsigned char> Pixels;
+    };
+
+    TextureArrayOptions Options;
+    std::vector<Image> Images;
+};
+
+#endif
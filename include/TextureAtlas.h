@@ -0,0 +1,123 @@
+//
+//  TextureAtlas.h
+//  Shaders
+//
+//  Created by Crunchy on 7/13/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Packs many small images into a few large RGBA pages so objects with
+//  different images can share one bind, and one draw. Placement is a
+//  skyline, bottom-left, tallest images first.
+//
+//  Every image gets a gutter of its own edge texels, `Padding` wide. A
+//  gutter halves with each mip level, so the page only keeps the
+//  levels at which it is still a whole texel (GL_TEXTURE_MAX_LEVEL),
+//  and images are placed on that level's texel grid so no level mixes
+//  two images inside one texel. Wrapping (GL_REPEAT) is not available
+//  inside an atlas; sprites and meshes that tile need a texture of
+//  their own.
+//
+
+#ifndef TextureAtlas_h
+#define TextureAtlas_h
+
+#include <glad/3.3/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLObject.h"
+#include "MipChain.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ThreadPool;
+
+// Where one image ended up
+struct AtlasRegion
+{
+    size_t Page   = 0;
+    int    X      = 0;     // texels, image proper (gutter excluded)
+    int    Y      = 0;
+    int    Width  = 0;
+    int    Height = 0;
+
+    glm::vec2 Offset = glm::vec2(0.0f);
+    glm::vec2 Scale  = glm::vec2(1.0f);
+
+    // The image's own [0,1] UVs -> page UVs
+    glm::vec2 map(const glm::vec2& uv) const { return Offset + uv * Scale; }
+};
+
+struct AtlasOptions
+{
+    int          PageSize = 2048;
+    int          Padding  = 8;        // gutter at level 0, in texels
+    bool         Srgb     = true;     // for mip filtering
+    ThreadPool * Pool     = nullptr;  // for mip generation
+};
+
+class TextureAtlas
+{
+public:
+    size_t pageCount() const { return Pages.size(); }
+    int maxLevel() const     { return MaxLevel; }
+
+    // Level 0 first, maxLevel() + 1 levels
+    const std::vector<MipImage>& page(size_t index) const { return Pages[index]; }
+
+    const AtlasRegion * find(const std::string& name) const;
+
+    // Fraction of each page's texels covered by images, gutters excluded
+    double coverage(size_t page) const;
+
+    // GL thread. Creates one texture per page.
+    void upload();
+    GLuint texture(size_t page) const { return Textures[page].id(); }
+    void bind(size_t page, GLuint unit) const;
+
+    // Maps the UVs of `count` interleaved vertices in place
+    static void rewriteUVs(float * vertices, size_t count, size_t strideFloats, size_t uvOffsetFloats,
+                           const AtlasRegion& region);
+
+private:
+    friend class TextureAtlasBuilder;
+
+    std::vector<std::vector<MipImage>> Pages;
+    std::vector<GLTexture> Textures;
+    std::vector<size_t> CoveredTexels;
+    std::unordered_map<std::string, AtlasRegion> Regions;
+    int MaxLevel = 0;
+};
+
+class TextureAtlasBuilder
+{
+public:
+    explicit TextureAtlasBuilder(const AtlasOptions& options = AtlasOptions());
+
+    // Rows in upload order (bottom first). 1 to 4 channels, stored as
+    // RGBA the way GL expands them. False if it can never fit a page.
+    bool add(const std::string& name, const unsigned char * pixels, int width, int height, int channels);
+
+    // Decodes through ImageDecoder, flipped; the name is the path
+    bool addFile(const std::string& path);
+
+    // Packs everything added so far, fills gutters, builds mips
+    TextureAtlas build() const;
+
+private:
+    struct Image
+    {
+        std::string Name;
+        int Width  = 0;
+        int Height = 0;
+        std::vector<unsigned char> Pixels;  // RGBA
+    };
+
+    AtlasOptions Options;
+    int Levels;       // mip levels kept below level 0
+    int Alignment;    // 1 << Levels
+    std::vector<Image> Images;
+};
+
+#endif
@@ -0,0 +1,91 @@
+//
+//  TextureCache.h
+//  Shaders
+//
+//  Created by Crunchy on 6/29/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Shares textures between everything that asks for the same image
+//  with the same sampling parameters, so each is decoded and uploaded
+//  once. Handles are shared_ptrs; the cache keeps one of its own, and
+//  a texture nobody else holds is kept around until the memory budget
+//  runs out, least recently acquired first.
+//
+
+#ifndef TextureCache_h
+#define TextureCache_h
+
+#include "Texture.h"
+#include "TextureLoader.h"
+
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct TextureCacheStats
+{
+    unsigned int Hits      = 0;
+    unsigned int Misses    = 0;
+    unsigned int Evictions = 0;
+    size_t EvictedBytes    = 0;
+};
+
+// One resident texture, for monitoring
+struct TextureCacheEntry
+{
+    std::string Path;
+    size_t      Bytes      = 0;
+    long        References = 0;    // handles held outside the cache
+    bool        Ready      = false;
+};
+
+class TextureCache
+{
+public:
+    explicit TextureCache(TextureLoader& loader, size_t budgetBytes = 256u << 20);
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Returns the cached texture, or starts loading it
+    std::shared_ptr<Texture> acquire(const std::string& path, const TextureParams& params = TextureParams());
+
+    // GL thread, once per frame. Runs the loader's update, then evicts
+    // unreferenced textures until the resident set fits the budget.
+    size_t update();
+
+    // Drops every texture nobody else holds, regardless of budget
+    void clear();
+
+    void setBudget(size_t budgetBytes) { Budget = budgetBytes; }
+    size_t budget() const { return Budget; }
+
+    // Over ready textures only; one still loading has no size yet
+    size_t residentBytes() const;
+    size_t size() const { return Entries.size(); }
+
+    // Most recently acquired first
+    std::vector<TextureCacheEntry> resident() const;
+
+    const TextureCacheStats& stats() const { return Stats; }
+    void printStats(std::ostream& out) const;
+
+private:
+    typedef std::list<std::shared_ptr<Texture>> LruList;
+
+    TextureLoader& Loader;
+    size_t Budget;
+
+    LruList Lru;                                             // front is most recent
+    std::unordered_map<std::string, LruList::iterator> Entries;
+
+    TextureCacheStats Stats;
+
+    static std::string MakeKey(const std::string& path, const TextureParams& params);
+    void Evict(size_t budget);
+};
+
+#endif
@@ -0,0 +1,134 @@
+//
+//  TextureContainer.h
+//  Shaders
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Baked textures (".tex"), written by source/tools/bake_textures.cpp.
+//  Every mip level is stored ready to hand to glTexImage2D, so loading
+//  one is an mmap and an upload with no decode:
+//
+//      TextureContainerHeader
+//      TextureContainerLevel[LevelCount]     largest first
+//      level payloads, each 16 byte aligned
+//
+//  Little endian, offsets from the start of the file. Rows are packed
+//  (no alignment padding) and already flipped if the header says so.
+//  Compressed levels are rows of 4x4 blocks, the way
+//  glCompressedTexImage2D takes them.
+//
+
+#ifndef TextureContainer_h
+#define TextureContainer_h
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TextureFormat : uint32_t
+{
+    R8    = 1,
+    RG8   = 2,
+    RGB8  = 3,
+    RGBA8 = 4,
+
+    // 4x4 blocks; see BlockCompression.h
+    BC1   = 16,     // RGB, 8 bytes a block
+    BC3   = 17,     // RGBA, 16 bytes a block
+
+    // Half floats, for HDR images
+    RGB16F  = 32,
+    RGBA16F = 33,
+};
+
+struct TextureContainerHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Format;        // TextureFormat
+    uint32_t Flags;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t LevelCount;
+    uint32_t Reserved;
+    uint64_t SourceHash;    // of the image file it was baked from
+};
+
+struct TextureContainerLevel
+{
+    uint32_t Width;
+    uint32_t Height;
+    uint64_t Offset;
+    uint64_t Size;
+};
+
+static_assert(sizeof(TextureContainerHeader) == 40, "TextureContainerHeader is a file format");
+static_assert(sizeof(TextureContainerLevel) == 24, "TextureContainerLevel is a file format");
+
+// One level's pixels, wherever they live
+struct TextureLevel
+{
+    int Width  = 0;
+    int Height = 0;
+    const unsigned char * Data = nullptr;
+    size_t Size = 0;
+};
+
+class TextureContainer
+{
+public:
+    static const uint32_t MAGIC   = 0x42584554;    // "TEXB"
+    static const uint32_t VERSION = 1;
+    static const uint32_t FLIPPED = 1 << 0;
+
+    // Maps the file and checks the header and level table against it
+    explicit TextureContainer(const std::string& path);
+
+    bool isOpen() const              { return Header != nullptr; }
+    const std::string& error() const { return Error; }
+
+    TextureFormat format() const { return static_cast<TextureFormat>(Header->Format); }
+    int width() const            { return (int)Header->Width; }
+    int height() const           { return (int)Header->Height; }
+    bool isFlipped() const       { return (Header->Flags & FLIPPED) != 0; }
+    uint64_t sourceHash() const  { return Header->SourceHash; }
+
+    size_t levelCount() const { return Header->LevelCount; }
+    TextureLevel level(size_t index) const;
+
+    // Whole file, for byte counts
+    size_t fileSize() const { return File.size(); }
+
+    // Levels largest first, each packed. False with a message on failure.
+    static bool write(const std::string& path, TextureFormat format, bool flipped, uint64_t sourceHash,
+                      const std::vector<TextureLevel>& levels, std::string& error);
+
+    // Reads just the header, for deciding whether to rebake. 0 if unreadable.
+    static uint64_t readSourceHash(const std::string& path);
+
+    // Paths ending in ".tex"
+    static bool isContainerPath(const std::string& path);
+
+    // Channels the format stores; 0 if unknown
+    static int channels(TextureFormat format);
+
+    static bool isCompressed(TextureFormat format);
+    static bool isHalfFloat(TextureFormat format);
+
+    // Bytes of one packed level
+    static size_t levelSize(TextureFormat format, int width, int height);
+
+private:
+    MappedFile File;
+    const TextureContainerHeader * Header = nullptr;
+    const TextureContainerLevel  * Levels = nullptr;
+    std::string Error;
+
+    bool Validate();
+};
+
+#endif
@@ -0,0 +1,122 @@
+//
+//  TextureLoader.h
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Loads textures without stalling the render loop:
+//
+//      worker pool   ImageDecoder (map file -> stbi; HDR to half floats)
+//      GL thread     update(): copy (and flip) into a pixel buffer from
+//                    a small ring -> glTexImage2D from the buffer -> fence
+//
+//  load() returns at once with a Texture that shows the placeholder
+//  until update() has uploaded it. A ring slot is reused only after
+//  its fence has signalled, so update() never waits on the GPU; if
+//  every slot is busy the rest waits for the next frame.
+//
+//  Textures loaded with TextureParams::Stream go up smallest mips
+//  first, GL_TEXTURE_BASE_LEVEL clamped to what has arrived. Each
+//  update() then adds larger levels, through the same ring, until the
+//  frame's stream budget is spent: the texture whose screen size is
+//  furthest beyond its resident level goes first.
+//
+
+#ifndef TextureLoader_h
+#define TextureLoader_h
+
+#include <glad/3.3/glad.h>
+
+#include "GLObject.h"
+#include "Texture.h"
+#include "ThreadPool.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TextureLoaderStats
+{
+    unsigned int Requested = 0;
+    unsigned int Uploaded  = 0;
+    unsigned int Failed    = 0;
+    unsigned int LevelsStreamed = 0;
+    size_t BytesUploaded   = 0;
+    size_t BytesStreamed   = 0;
+    double DecodeMs        = 0.0;   // summed over workers
+    double UploadMs        = 0.0;   // GL thread time inside update()
+};
+
+class TextureLoader
+{
+public:
+    // GL thread only; creates the placeholder and the buffer ring.
+    // 0 workers means one per hardware thread.
+    explicit TextureLoader(size_t workers = 0, size_t ringSize = 4);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    std::shared_ptr<Texture> load(const std::string& path, const TextureParams& params = TextureParams());
+
+    // GL thread, once per frame. Uploads what has been decoded, at most
+    // one image per free ring slot. Returns the number finished.
+    size_t update();
+
+    // Blocks until everything requested so far is uploaded
+    void finish();
+
+    // Requested but not yet uploaded (or failed)
+    size_t pending() const;
+
+    // Uploaded, with larger levels still to come. GL thread only.
+    size_t streaming() const { return Streaming.size(); }
+
+    // Bytes of streamed levels update() may upload per frame. A level
+    // larger than the budget goes up alone, in a frame of its own.
+    void setStreamBudget(size_t bytes) { StreamBudget = bytes; }
+    size_t streamBudget() const        { return StreamBudget; }
+
+    GLuint placeholder() const { return Placeholder.id(); }
+    const TextureLoaderStats& stats() const { return Stats; }
+
+private:
+    struct DecodedImage;
+
+    struct RingSlot
+    {
+        GLBuffer Buffer;
+        size_t   Capacity = 0;
+        GLsync   Fence    = 0;
+    };
+
+    ThreadPool Workers;
+    GLTexture  Placeholder;
+
+    std::vector<RingSlot> Ring;
+    size_t NextSlot = 0;
+
+    mutable std::mutex Lock;
+    std::deque<std::unique_ptr<DecodedImage>> Decoded;   // guarded by Lock
+    size_t InFlight = 0;                                 // guarded by Lock
+    double DecodeMs = 0.0;                               // guarded by Lock
+
+    std::vector<std::unique_ptr<DecodedImage>> Streaming;   // hold their textures weakly
+    size_t StreamBudget = 4 << 20;
+
+    TextureLoaderStats Stats;
+
+    void Decode(std::shared_ptr<Texture> texture);
+    void DecodeImage(DecodedImage& image);
+    void Map(DecodedImage& image);
+    RingSlot * FreeSlot();
+    void Upload(std::unique_ptr<DecodedImage> image, RingSlot& slot);
+    size_t UploadLevels(DecodedImage& image, size_t first, size_t end, RingSlot& slot);
+    size_t Stream();
+};
+
+#endif
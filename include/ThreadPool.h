@@ -0,0 +1,61 @@
+//
+//  ThreadPool.h
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Fixed set of worker threads fed from one FIFO queue. Tasks must not
+//  touch GL; hand results back to the GL thread instead.
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+
+    // Runs whatever is still queued, then joins
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until the queue is empty and no task is running
+    void wait();
+
+    // Splits [0, count) into contiguous ranges, runs them on the workers
+    // and the calling thread, and returns once all are done. The caller
+    // claims ranges itself, so a task may call it without deadlocking.
+    void parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+
+    size_t size() const { return Workers.size(); }
+
+    static size_t hardwareThreads();
+
+private:
+    std::vector<std::thread>          Workers;
+    std::deque<std::function<void()>> Tasks;
+
+    std::mutex              Lock;
+    std::condition_variable Wake;
+    std::condition_variable Idle;
+    size_t Running  = 0;
+    bool   Stopping = false;
+
+    void Run();
+};
+
+#endif
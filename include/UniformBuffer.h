@@ -0,0 +1,185 @@
+//
+//  UniformBuffer.h
+//  Shaders
+//
+//  Created by Crunchy on 6/12/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Uniform buffer objects backed by plain C++ structs of glm types.
+//  The struct is checked against the std140 rules at compile time,
+//  bound to a binding point once, and every program that declares the
+//  block sees each update() without per-program uniform calls.
+//
+//      struct CameraBlock
+//      {
+//          glm::mat4 View;
+//          glm::mat4 Projection;
+//          glm::vec3 Position;
+//          float     Exposure;
+//      };
+//      STD140_LAYOUT(CameraBlock,
+//          STD140_FIELD(CameraBlock, View),
+//          STD140_FIELD(CameraBlock, Projection),
+//          STD140_FIELD(CameraBlock, Position),
+//          STD140_FIELD(CameraBlock, Exposure));
+//
+//      UniformBuffer<CameraBlock> camera("Camera", 0);
+//      camera.update(block);   // once per frame
+//
+//  Where std140 needs padding (a float followed by a vec3, say), use
+//  alignas(16) on the member rather than dummy fields.
+//
+
+#ifndef UniformBuffer_h
+#define UniformBuffer_h
+
+#include <glad/3.3/glad.h>
+#include <glm/glm.hpp>
+
+#include "GLObject.h"
+#include "GLState.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// std140 base alignment and size of each supported member type
+/*---------------------------------*/
+template <typename T>
+struct Std140Type
+{
+    static_assert(!std::is_same<T, bool>::value,
+                  "GLSL bool is 4 bytes in std140; use int32_t");
+    static_assert(!std::is_same<T, glm::mat3>::value,
+                  "glm::mat3 columns are not padded to vec4; use glm::mat3x4 for a GLSL mat3");
+    static_assert(std::is_same<T, bool>::value || std::is_same<T, glm::mat3>::value || sizeof(T) == 0,
+                  "Type is not supported in std140 blocks");
+};
+
+template <size_t A, size_t S>
+struct Std140Rule
+{
+    static const size_t Alignment = A;
+    static const size_t Size      = S;
+};
+
+template <> struct Std140Type<float>      : Std140Rule<4, 4>   {};
+template <> struct Std140Type<int32_t>    : Std140Rule<4, 4>   {};
+template <> struct Std140Type<uint32_t>   : Std140Rule<4, 4>   {};
+template <> struct Std140Type<glm::vec2>  : Std140Rule<8, 8>   {};
+template <> struct Std140Type<glm::ivec2> : Std140Rule<8, 8>   {};
+template <> struct Std140Type<glm::vec3>  : Std140Rule<16, 12> {};
+template <> struct Std140Type<glm::ivec3> : Std140Rule<16, 12> {};
+template <> struct Std140Type<glm::vec4>  : Std140Rule<16, 16> {};
+template <> struct Std140Type<glm::ivec4> : Std140Rule<16, 16> {};
+template <> struct Std140Type<glm::mat4>  : Std140Rule<16, 64> {};
+
+// GLSL mat3 columns are padded to vec4, which is exactly glm::mat3x4
+template <> struct Std140Type<glm::mat3x4> : Std140Rule<16, 48> {};
+
+// Arrays use a 16 byte stride, so only 16 byte multiples match C++ arrays
+template <typename T, size_t N>
+struct Std140Type<T[N]> : Std140Rule<16, Std140Type<T>::Size * N>
+{
+    static_assert(Std140Type<T>::Size % 16 == 0,
+                  "std140 arrays have a 16 byte element stride; use vec4/ivec4/mat4 elements");
+};
+
+// Compile-time layout check
+/*---------------------------------*/
+struct Std140Field
+{
+    size_t Offset;
+    size_t Size;
+    size_t Alignment;
+    size_t Std140Size;
+
+    template <typename T>
+    static constexpr Std140Field Of(size_t offset)
+    {
+        return { offset, sizeof(T), Std140Type<T>::Alignment, Std140Type<T>::Size };
+    }
+};
+
+constexpr size_t Std140RoundUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Fields must be listed in declaration order. Each must sit exactly
+// where std140 places it, and the block must end where the last field
+// does (rounded to vec4), which catches fields left off the list.
+template <typename Block, size_t N>
+constexpr bool Std140Matches(const Std140Field (&fields)[N])
+{
+    size_t expected = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        expected = Std140RoundUp(expected, fields[i].Alignment);
+        if (fields[i].Offset != expected || fields[i].Size != fields[i].Std140Size)
+            return false;
+        expected += fields[i].Std140Size;
+    }
+    return Std140RoundUp(expected, 16) == Std140RoundUp(sizeof(Block), 16);
+}
+
+template <typename Block>
+struct Std140Verified : std::false_type {};
+
+#define STD140_FIELD(Block, Member) \
+    Std140Field::Of<decltype(Block::Member)>(offsetof(Block, Member))
+
+#define STD140_LAYOUT(Block, ...)                                                   \
+    template <> struct Std140Verified<Block> : std::true_type                      \
+    {                                                                               \
+        static_assert(Std140Matches<Block>({ __VA_ARGS__ }),                        \
+                      #Block " does not match the std140 layout of its fields");    \
+    }
+
+// Block name -> binding point, applied to every program after linking
+/*---------------------------------*/
+class UniformBlockBindings
+{
+public:
+    static void set(const std::string& blockName, GLuint binding);
+
+    // Points each registered block the program declares at its binding
+    static void apply(GLuint program);
+};
+
+// Uniform buffer
+/*---------------------------------*/
+template <typename Block>
+class UniformBuffer
+{
+    static_assert(Std140Verified<Block>::value,
+                  "Declare STD140_LAYOUT(Block, ...) before using it in a UniformBuffer");
+
+public:
+    UniformBuffer(const std::string& blockName, GLuint binding)
+        : Buffer(GLBuffer::create()), Binding(binding)
+    {
+        GLState.bindBuffer(GL_UNIFORM_BUFFER, Buffer.id());
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_DYNAMIC_DRAW);
+
+        // Also sets the generic binding, which the cache already holds as Buffer
+        glBindBufferBase(GL_UNIFORM_BUFFER, Binding, Buffer.id());
+        UniformBlockBindings::set(blockName, Binding);
+    }
+
+    // Variables
+    GLBuffer Buffer;
+    GLuint   Binding;
+
+    // Methods
+    // One upload per call regardless of how many programs read the block.
+    // Persistent mapping needs GL 4.4, so the 3.3 path is glBufferSubData.
+    void update(const Block& data) const
+    {
+        GLState.bindBuffer(GL_UNIFORM_BUFFER, Buffer.id());
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &data);
+    }
+};
+
+#endif
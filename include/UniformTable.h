@@ -0,0 +1,68 @@
+//
+//  UniformTable.h
+//  Shaders
+//
+//  Created by Crunchy on 6/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#ifndef UniformTable_h
+#define UniformTable_h
+
+#include <glad/3.3/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FNV-1a hash of a uniform name. constexpr so render code can
+// resolve names like HashUniformName("uBlend") at compile time.
+constexpr uint32_t HashUniformName(const char * name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= static_cast<uint8_t>(*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Pre-resolved uniform location. Location -1 is silently
+// ignored by glUniform*, same as an unknown name.
+struct UniformHandle
+{
+    GLint Location = -1;
+
+    bool isValid() const { return Location != -1; }
+};
+
+// Flat open-addressing (linear probing) table of a program's
+// active uniforms, filled once right after glLinkProgram.
+class UniformTable
+{
+public:
+    // Methods
+    void build(GLuint program);
+    void clear();
+
+    UniformHandle find(const std::string& name) const;
+    UniformHandle find(uint32_t hash) const;
+
+    size_t size() const { return Count; }
+
+private:
+    struct Entry
+    {
+        uint32_t    Hash     = 0;
+        GLint       Location = -1;
+        std::string Name;
+    };
+
+    std::vector<Entry> Slots;
+    size_t Count = 0;
+
+    void Insert(const std::string& name, GLint location);
+};
+
+#endif
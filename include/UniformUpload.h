@@ -0,0 +1,99 @@
+//
+//  UniformUpload.h
+//  Shaders
+//
+//  Created by Crunchy on 6/14/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Maps a C++ value type to the glUniform*v call that uploads it.
+//  Picked at compile time, so a span of N values is always a single
+//  call with count N. N must be at least 1: the glm uploads take the
+//  address of the first value.
+//
+
+#ifndef UniformUpload_h
+#define UniformUpload_h
+
+#include <glad/3.3/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <type_traits>
+
+template <typename T>
+struct UniformUpload
+{
+    static_assert(sizeof(T) == 0, "No glUniform* upload for this type");
+};
+
+template <> struct UniformUpload<float>
+{
+    static void upload(GLint location, GLsizei count, const float * values)
+    { glUniform1fv(location, count, values); }
+};
+
+template <> struct UniformUpload<int>
+{
+    static void upload(GLint location, GLsizei count, const int * values)
+    { glUniform1iv(location, count, values); }
+};
+
+template <> struct UniformUpload<unsigned int>
+{
+    static void upload(GLint location, GLsizei count, const unsigned int * values)
+    { glUniform1uiv(location, count, values); }
+};
+
+template <> struct UniformUpload<glm::vec2>
+{
+    static void upload(GLint location, GLsizei count, const glm::vec2 * values)
+    { glUniform2fv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::vec3>
+{
+    static void upload(GLint location, GLsizei count, const glm::vec3 * values)
+    { glUniform3fv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::vec4>
+{
+    static void upload(GLint location, GLsizei count, const glm::vec4 * values)
+    { glUniform4fv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::ivec2>
+{
+    static void upload(GLint location, GLsizei count, const glm::ivec2 * values)
+    { glUniform2iv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::ivec3>
+{
+    static void upload(GLint location, GLsizei count, const glm::ivec3 * values)
+    { glUniform3iv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::ivec4>
+{
+    static void upload(GLint location, GLsizei count, const glm::ivec4 * values)
+    { glUniform4iv(location, count, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::mat3>
+{
+    static void upload(GLint location, GLsizei count, const glm::mat3 * values)
+    { glUniformMatrix3fv(location, count, GL_FALSE, glm::value_ptr(*values)); }
+};
+
+template <> struct UniformUpload<glm::mat4>
+{
+    static void upload(GLint location, GLsizei count, const glm::mat4 * values)
+    { glUniformMatrix4fv(location, count, GL_FALSE, glm::value_ptr(*values)); }
+};
+
+// glm types are tightly packed, so arrays of them are one contiguous span
+static_assert(sizeof(glm::vec3[2]) == 6 * sizeof(float), "glm::vec3 must be tightly packed");
+static_assert(sizeof(glm::mat4[2]) == 32 * sizeof(float), "glm::mat4 must be tightly packed");
+
+#endif
@@ -0,0 +1,252 @@
+//
+//  VertexLayout.h
+//  Shaders
+//
+//  Created by Crunchy on 7/25/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Vertex attribute setup worked out at compile time from a struct of
+//  glm types, in place of glVertexAttribPointer calls with hand counted
+//  strides and offsets:
+//
+//      struct Vertex
+//      {
+//          glm::vec3 Position;
+//          glm::vec3 Colour;
+//          glm::vec2 UV;
+//      };
+//
+//      using VertexFormat = VertexLayout<Vertex,
+//          VERTEX_ATTRIBUTE(Vertex, Position, 0),
+//          VERTEX_ATTRIBUTE(Vertex, Colour,   1),
+//          VERTEX_ATTRIBUTE(Vertex, UV,       2)>;
+//
+//      GLState.bindVertexArray(vao.id());
+//      GLState.bindBuffer(GL_ARRAY_BUFFER, vbo.id());
+//      VertexFormat::upload(vertices.data(), vertices.size(), VertexStreams::Split);
+//
+//  Interleaved stores whole vertices one after another. Split gives
+//  each attribute a packed stream of its own, back to back in the one
+//  buffer, so a pass that reads only positions (depth, shadows) fetches
+//  only positions. A mesh switches between them with the one argument.
+//
+//  Component types and counts come from the member types: float, int
+//  and unsigned scalars and glm vectors of them, or of 8 and 16 bit
+//  integers. Integers reach the shader as integers (ivec, uvec) unless
+//  declared with VERTEX_ATTRIBUTE_NORMALIZED, which maps them to 0 to 1
+//  (or -1 to 1) floats.
+//
+
+#ifndef VertexLayout_h
+#define VertexLayout_h
+
+#include <glad/3.3/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class VertexStreams
+{
+    Interleaved,    // array of structs
+    Split,          // one packed stream per attribute
+};
+
+// GL component type of each scalar
+/*---------------------------------*/
+template <typename T>
+struct VertexComponent
+{
+    static_assert(sizeof(T) == 0, "No vertex attribute component type for this type");
+};
+
+template <> struct VertexComponent<float>    { static const GLenum Type = GL_FLOAT;          static const bool Integer = false; };
+template <> struct VertexComponent<int8_t>   { static const GLenum Type = GL_BYTE;           static const bool Integer = true;  };
+template <> struct VertexComponent<uint8_t>  { static const GLenum Type = GL_UNSIGNED_BYTE;  static const bool Integer = true;  };
+template <> struct VertexComponent<int16_t>  { static const GLenum Type = GL_SHORT;          static const bool Integer = true;  };
+template <> struct VertexComponent<uint16_t> { static const GLenum Type = GL_UNSIGNED_SHORT; static const bool Integer = true;  };
+template <> struct VertexComponent<int32_t>  { static const GLenum Type = GL_INT;            static const bool Integer = true;  };
+template <> struct VertexComponent<uint32_t> { static const GLenum Type = GL_UNSIGNED_INT;   static const bool Integer = true;  };
+
+// Scalars and glm vectors of them
+/*---------------------------------*/
+template <typename T>
+struct VertexAttributeFormat : VertexComponent<T>
+{
+    static const GLint Components = 1;
+};
+
+template <glm::length_t L, typename T, glm::qualifier Q>
+struct VertexAttributeFormat<glm::vec<L, T, Q>> : VertexComponent<T>
+{
+    static const GLint Components = L;
+};
+
+// One attribute: its type, where it sits in the vertex, its location
+/*---------------------------------*/
+template <typename T, size_t Offset, GLuint Location, bool Normalized = false>
+struct VertexAttribute
+{
+    using Format = VertexAttributeFormat<T>;
+    static_assert(!Normalized || Format::Integer, "Only integer attributes can be normalized");
+
+    static constexpr size_t size()       { return sizeof(T); }
+    static constexpr size_t offset()     { return Offset; }
+    static constexpr GLuint location()   { return Location; }
+
+    // Points the attribute at the bound GL_ARRAY_BUFFER
+    static void point(GLsizei stride, size_t start)
+    {
+        if (Format::Integer && !Normalized)
+            glVertexAttribIPointer(Location, Format::Components, Format::Type, stride, (const void *)start);
+        else
+            glVertexAttribPointer(Location, Format::Components, Format::Type, Normalized ? GL_TRUE : GL_FALSE,
+                                  stride, (const void *)start);
+        glEnableVertexAttribArray(Location);
+    }
+
+    // Copies this attribute out of each vertex into a packed stream
+    static void gather(const unsigned char * vertices, size_t stride, size_t count, unsigned char * stream)
+    {
+        for (size_t i = 0; i < count; ++i)
+            std::memcpy(stream + i * sizeof(T), vertices + i * stride + Offset, sizeof(T));
+    }
+};
+
+#define VERTEX_ATTRIBUTE(Vertex, Member, Location) \
+    VertexAttribute<decltype(Vertex::Member), offsetof(Vertex, Member), Location>
+
+#define VERTEX_ATTRIBUTE_NORMALIZED(Vertex, Member, Location) \
+    VertexAttribute<decltype(Vertex::Member), offsetof(Vertex, Member), Location, true>
+
+namespace VertexLayoutChecks
+{
+    constexpr bool UniqueLocations(uint32_t)
+    {
+        return true;
+    }
+
+    template <typename... Rest>
+    constexpr bool UniqueLocations(uint32_t seen, GLuint first, Rest... rest)
+    {
+        return first < 16 && (seen & (1u << first)) == 0 && UniqueLocations(seen | (1u << first), rest...);
+    }
+
+    constexpr bool Fits(size_t)
+    {
+        return true;
+    }
+
+    template <typename... Rest>
+    constexpr bool Fits(size_t vertexSize, size_t end, Rest... rest)
+    {
+        return end <= vertexSize && Fits(vertexSize, rest...);
+    }
+}
+
+// The whole vertex
+/*---------------------------------*/
+template <typename Vertex, typename... Attributes>
+class VertexLayout
+{
+    static_assert(sizeof...(Attributes) > 0, "A vertex layout needs attributes");
+    static_assert(std::is_standard_layout<Vertex>::value, "Vertex must be standard layout for offsetof");
+    static_assert(VertexLayoutChecks::UniqueLocations(0u, Attributes::location()...),
+                  "Attribute locations must be distinct and below 16");
+    static_assert(VertexLayoutChecks::Fits(sizeof(Vertex), (Attributes::offset() + Attributes::size())...),
+                  "An attribute runs past the end of the vertex");
+
+public:
+    static const size_t ATTRIBUTES = sizeof...(Attributes);
+
+    static constexpr GLsizei stride() { return (GLsizei)sizeof(Vertex); }
+
+    // Where each attribute's data starts in a buffer of `count` vertices,
+    // then the total. Split streams start 4 byte aligned.
+    static std::array<size_t, ATTRIBUTES + 1> streamOffsets(VertexStreams streams, size_t count)
+    {
+        std::array<size_t, ATTRIBUTES + 1> offsets;
+        if (streams == VertexStreams::Interleaved)
+        {
+            const size_t interleaved[] = { Attributes::offset()... };
+            std::copy(std::begin(interleaved), std::end(interleaved), offsets.begin());
+            offsets[ATTRIBUTES] = sizeof(Vertex) * count;
+            return offsets;
+        }
+
+        const size_t sizes[] = { Attributes::size()... };
+        size_t offset = 0;
+        for (size_t i = 0; i < ATTRIBUTES; ++i)
+        {
+            offsets[i] = offset;
+            offset = (offset + sizes[i] * count + 3) & ~(size_t)3;
+        }
+        offsets[ATTRIBUTES] = offset;
+        return offsets;
+    }
+
+    static size_t bufferSize(VertexStreams streams, size_t count)
+    {
+        return streamOffsets(streams, count)[ATTRIBUTES];
+    }
+
+    // Writes bufferSize() bytes
+    static void pack(const Vertex * vertices, size_t count, VertexStreams streams, void * destination)
+    {
+        if (streams == VertexStreams::Interleaved)
+            std::memcpy(destination, vertices, sizeof(Vertex) * count);
+        else
+            Gather(reinterpret_cast<const unsigned char *>(vertices), count, static_cast<unsigned char *>(destination),
+                   streamOffsets(streams, count), std::index_sequence_for<Attributes...>());
+    }
+
+    // Points every attribute of the bound vertex array at the bound
+    // GL_ARRAY_BUFFER, laid out as pack() writes it from `base` on
+    static void setAttributes(VertexStreams streams, size_t count, size_t base = 0)
+    {
+        Point(streams, base, streamOffsets(streams, count), std::index_sequence_for<Attributes...>());
+    }
+
+    // Both, into the bound GL_ARRAY_BUFFER
+    static void upload(const Vertex * vertices, size_t count, VertexStreams streams, GLenum usage = GL_STATIC_DRAW)
+    {
+        if (streams == VertexStreams::Interleaved)
+        {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * count, vertices, usage);
+        }
+        else
+        {
+            std::vector<unsigned char> packed(bufferSize(streams, count));
+            pack(vertices, count, streams, packed.data());
+            glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), usage);
+        }
+        setAttributes(streams, count);
+    }
+
+private:
+    template <size_t... I>
+    static void Gather(const unsigned char * vertices, size_t count, unsigned char * destination,
+                       const std::array<size_t, ATTRIBUTES + 1>& offsets, std::index_sequence<I...>)
+    {
+        const int expand[] = { (Attributes::gather(vertices, sizeof(Vertex), count, destination + offsets[I]), 0)... };
+        (void)expand;
+    }
+
+    template <size_t... I>
+    static void Point(VertexStreams streams, size_t base, const std::array<size_t, ATTRIBUTES + 1>& offsets,
+                      std::index_sequence<I...>)
+    {
+        const bool split = streams == VertexStreams::Split;
+        const int expand[] = { (Attributes::point(split ? (GLsizei)Attributes::size() : stride(), base + offsets[I]), 0)... };
+        (void)expand;
+    }
+};
+
+#endif
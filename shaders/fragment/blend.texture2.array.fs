@@ -0,0 +1,21 @@
+#version 330 core
+#include "../include/texture.inputs.glsl"
+
+// blend.texture2.fs with both images as layers of one array texture,
+// so a whole batch of materials draws from a single bind. Pair with
+// vertex/base.array.vs.
+
+flat in ivec2 Layers;
+
+uniform sampler2DArray uTextures;
+uniform float uBlend = 0.5;
+
+void main()
+{
+    Color = mix
+    (
+        texture(uTextures, vec3(TexCoord, Layers.x)),
+        texture(uTextures, vec3(TexCoord, Layers.y)),
+        uBlend
+    );
+}
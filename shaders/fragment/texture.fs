@@ -0,0 +1,27 @@
+#version 330 core
+#include "../include/texture.inputs.glsl"
+
+// Permutations:
+//   (none)          single texture
+//   BLEND_TEXTURE2  mix uTexture1 and uTexture2 by uBlend
+
+uniform sampler2D uTexture1;
+
+#ifdef BLEND_TEXTURE2
+uniform sampler2D uTexture2;
+uniform float uBlend = 0.5;
+#endif
+
+void main()
+{
+#ifdef BLEND_TEXTURE2
+    Color = mix
+    (
+        texture(uTexture1, TexCoord),
+        texture(uTexture2, TexCoord),
+        uBlend
+    );
+#else
+    Color = texture(uTexture1, TexCoord);
+#endif
+}
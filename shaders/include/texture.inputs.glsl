@@ -0,0 +1,4 @@
+layout(location = 0) out vec4 Color;
+
+in vec3 Fragment;
+in vec2 TexCoord;
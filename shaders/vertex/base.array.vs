@@ -0,0 +1,31 @@
+#version 330 core
+layout (location = 0) in vec3 Vertex;
+layout (location = 1) in vec3 ColorVec;
+layout (location = 2) in vec2 TextureVec;
+
+// Permutations:
+//   (none)           layers from uLayers, per draw
+//   LAYER_ATTRIBUTE  layers from an integer attribute, per vertex or, with
+//                    glVertexAttribDivisor, per instance
+
+#ifdef LAYER_ATTRIBUTE
+layout (location = 3) in ivec2 LayerVec;
+#else
+uniform ivec2 uLayers;
+#endif
+
+out vec3 Fragment;
+out vec2 TexCoord;
+flat out ivec2 Layers;
+
+void main()
+{
+    gl_Position = vec4(Vertex, 1.0);
+    Fragment = ColorVec;
+    TexCoord  = TextureVec;
+#ifdef LAYER_ATTRIBUTE
+    Layers = LayerVec;
+#else
+    Layers = uLayers;
+#endif
+}
@@ -0,0 +1,343 @@
+//
+//  BlockCompression.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/6/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "BlockCompression.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define BLOCK_COMPRESSION_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // One 4x4 block, structure of arrays, as floats for the projection
+    struct Block
+    {
+        alignas(16) float R[16];
+        alignas(16) float G[16];
+        alignas(16) float B[16];
+        alignas(16) float A[16];
+        unsigned char Min[4];
+        unsigned char Max[4];
+    };
+
+    void GatherBlock(const unsigned char * pixels, int width, int height, int channels, int bx, int by, Block& block)
+    {
+        std::fill(block.Min, block.Min + 4, 255);
+        std::fill(block.Max, block.Max + 4, 0);
+
+        for (int y = 0; y < 4; ++y)
+        {
+            const unsigned char * row = pixels + (size_t)std::min(by * 4 + y, height - 1) * width * channels;
+            for (int x = 0; x < 4; ++x)
+            {
+                const unsigned char * texel = row + (size_t)std::min(bx * 4 + x, width - 1) * channels;
+                const unsigned char rgba[4] = { texel[0], texel[1], texel[2], channels == 4 ? texel[3] : (unsigned char)255 };
+
+                const int i = y * 4 + x;
+                block.R[i] = rgba[0];
+                block.G[i] = rgba[1];
+                block.B[i] = rgba[2];
+                block.A[i] = rgba[3];
+                for (int c = 0; c < 4; ++c)
+                {
+                    block.Min[c] = std::min(block.Min[c], rgba[c]);
+                    block.Max[c] = std::max(block.Max[c], rgba[c]);
+                }
+            }
+        }
+    }
+
+    // Quantises each texel's position between two endpoints to one of
+    // `steps` + 1 levels: round(dot(p - from, axis) * scale), clamped.
+    // Colour uses three channels, alpha passes zero axes for G and B.
+    void Project(const float from[4], const float axis[4], float scale, int steps, const float * values[4], int out[16])
+    {
+    #if BLOCK_COMPRESSION_SSE2
+        const __m128 fr = _mm_set1_ps(from[0]), fg = _mm_set1_ps(from[1]), fb = _mm_set1_ps(from[2]);
+        const __m128 dr = _mm_set1_ps(axis[0]), dg = _mm_set1_ps(axis[1]), db = _mm_set1_ps(axis[2]);
+        const __m128 s  = _mm_set1_ps(scale),   half = _mm_set1_ps(0.5f);
+        const __m128 lo = _mm_setzero_ps(),     hi = _mm_set1_ps((float)steps);
+
+        for (int i = 0; i < 16; i += 4)
+        {
+            __m128 t = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(values[0] + i), fr), dr);
+            t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(values[1] + i), fg), dg));
+            t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(values[2] + i), fb), db));
+            t = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(t, s), half), lo), hi);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_cvttps_epi32(t));
+        }
+    #else
+        for (int i = 0; i < 16; ++i)
+        {
+            const float t = (values[0][i] - from[0]) * axis[0]
+                          + (values[1][i] - from[1]) * axis[1]
+                          + (values[2][i] - from[2]) * axis[2];
+            out[i] = (int)std::min(std::max(t * scale + 0.5f, 0.0f), (float)steps);
+        }
+    #endif
+    }
+
+    uint16_t To565(const int rgb[3])
+    {
+        const int r = (rgb[0] * 31 + 127) / 255;
+        const int g = (rgb[1] * 63 + 127) / 255;
+        const int b = (rgb[2] * 31 + 127) / 255;
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void From565(uint16_t color, int rgb[3])
+    {
+        const int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    void Store16(unsigned char * out, uint16_t value)
+    {
+        out[0] = (unsigned char)(value & 0xFF);
+        out[1] = (unsigned char)(value >> 8);
+    }
+
+    // 8 bytes: two 565 endpoints, 2 bit indices. Always the four colour
+    // mode (first endpoint greater), which BC3 requires anyway.
+    void EncodeColor(const Block& block, unsigned char * out)
+    {
+        // Inset the bounding box by 1/16 of its size; the extremes are
+        // usually outliers and the box corners rarely texels
+        int high[3], low[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            const int inset = (block.Max[c] - block.Min[c]) >> 4;
+            high[c] = block.Max[c] - inset;
+            low[c]  = block.Min[c] + inset;
+        }
+
+        uint16_t c0 = To565(high), c1 = To565(low);
+        if (c0 < c1)
+            std::swap(c0, c1);
+
+        Store16(out, c0);
+        Store16(out + 2, c1);
+        if (c0 == c1)
+        {
+            std::memset(out + 4, 0, 4);
+            return;
+        }
+
+        // Project onto the axis between the decoded endpoints
+        int e0[3], e1[3];
+        From565(c0, e0);
+        From565(c1, e1);
+
+        const float from[4] = { (float)e1[0], (float)e1[1], (float)e1[2], 0.0f };
+        const float axis[4] = { (float)(e0[0] - e1[0]), (float)(e0[1] - e1[1]), (float)(e0[2] - e1[2]), 0.0f };
+        const float length  = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        const float * values[4] = { block.R, block.G, block.B, block.A };
+
+        int steps[16];
+        Project(from, axis, 3.0f / length, 3, values, steps);
+
+        // Step 0 is c1, step 3 is c0; BC1 orders them c0, c1, 2/3, 1/3
+        static const uint32_t remap[4] = { 1, 3, 2, 0 };
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+            indices |= remap[steps[i]] << (2 * i);
+
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = (unsigned char)(indices >> (8 * i));
+    }
+
+    // 8 bytes: two alpha endpoints, 3 bit indices, eight level mode
+    void EncodeAlpha(const Block& block, unsigned char * out)
+    {
+        const int inset = (block.Max[3] - block.Min[3]) >> 5;
+        const int a0 = block.Max[3] - inset;
+        const int a1 = block.Min[3] + inset;
+
+        out[0] = (unsigned char)a0;
+        out[1] = (unsigned char)a1;
+        if (a0 == a1)
+        {
+            std::memset(out + 2, 0, 6);
+            return;
+        }
+
+        const float from[4] = { (float)a1, 0.0f, 0.0f, 0.0f };
+        const float axis[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+        const float * values[4] = { block.A, block.A, block.A, block.A };
+
+        int steps[16];
+        Project(from, axis, 7.0f / (a0 - a1), 7, values, steps);
+
+        // Step 7 is a0, step 0 is a1, the rest interpolate from a0 down
+        uint64_t indices = 0;
+        for (int i = 0; i < 16; ++i)
+        {
+            const int step = steps[i];
+            const uint64_t index = step == 7 ? 0 : step == 0 ? 1 : (uint64_t)(8 - step);
+            indices |= index << (3 * i);
+        }
+
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = (unsigned char)(indices >> (8 * i));
+    }
+
+    void DecodeColor(const unsigned char * in, bool fourColor, unsigned char palette[4][4], uint32_t& indices)
+    {
+        const uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+        const uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+        indices = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+
+        int e0[3], e1[3];
+        From565(c0, e0);
+        From565(c1, e1);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[0][c] = (unsigned char)e0[c];
+            palette[1][c] = (unsigned char)e1[c];
+            if (fourColor || c0 > c1)
+            {
+                palette[2][c] = (unsigned char)((2 * e0[c] + e1[c]) / 3);
+                palette[3][c] = (unsigned char)((e0[c] + 2 * e1[c]) / 3);
+            }
+            else
+            {
+                palette[2][c] = (unsigned char)((e0[c] + e1[c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[0][3] = palette[1][3] = palette[2][3] = 255;
+        palette[3][3] = (fourColor || c0 > c1) ? 255 : 0;
+    }
+
+    void DecodeAlpha(const unsigned char * in, unsigned char alphas[8], uint64_t& indices)
+    {
+        const int a0 = in[0], a1 = in[1];
+        indices = 0;
+        for (int i = 0; i < 6; ++i)
+            indices |= (uint64_t)in[2 + i] << (8 * i);
+
+        alphas[0] = (unsigned char)a0;
+        alphas[1] = (unsigned char)a1;
+        if (a0 > a1)
+        {
+            for (int k = 2; k < 8; ++k)
+                alphas[k] = (unsigned char)(((8 - k) * a0 + (k - 1) * a1) / 7);
+        }
+        else
+        {
+            for (int k = 2; k < 6; ++k)
+                alphas[k] = (unsigned char)(((6 - k) * a0 + (k - 1) * a1) / 5);
+            alphas[6] = 0;
+            alphas[7] = 255;
+        }
+    }
+}
+
+std::vector<unsigned char> CompressBlocks(TextureFormat format, const unsigned char * pixels,
+                                          int width, int height, int channels, ThreadPool * pool)
+{
+    const int blocksWide = (width + 3) / 4;
+    const int blocksHigh = (height + 3) / 4;
+    const size_t blockBytes = format == TextureFormat::BC1 ? 8 : 16;
+
+    std::vector<unsigned char> blocks(TextureContainer::levelSize(format, width, height));
+    unsigned char * base = blocks.data();
+
+    auto encodeRows = [=](size_t begin, size_t end)
+    {
+        Block block;
+        for (size_t by = begin; by < end; ++by)
+        {
+            unsigned char * out = base + by * blocksWide * blockBytes;
+            for (int bx = 0; bx < blocksWide; ++bx, out += blockBytes)
+            {
+                GatherBlock(pixels, width, height, channels, bx, (int)by, block);
+                if (format == TextureFormat::BC3)
+                {
+                    EncodeAlpha(block, out);
+                    EncodeColor(block, out + 8);
+                }
+                else
+                {
+                    EncodeColor(block, out);
+                }
+            }
+        }
+    };
+
+    if (pool)
+        pool->parallelFor((size_t)blocksHigh, encodeRows);
+    else
+        encodeRows(0, (size_t)blocksHigh);
+    return blocks;
+}
+
+std::vector<unsigned char> DecompressBlocks(TextureFormat format, const unsigned char * blocks, int width, int height)
+{
+    std::vector<unsigned char> rgba((size_t)width * height * 4);
+    const int blocksWide = (width + 3) / 4;
+    const int blocksHigh = (height + 3) / 4;
+    const bool bc3 = format == TextureFormat::BC3;
+
+    for (int by = 0; by < blocksHigh; ++by)
+    {
+        for (int bx = 0; bx < blocksWide; ++bx, blocks += bc3 ? 16 : 8)
+        {
+            unsigned char palette[4][4];
+            uint32_t colorIndices;
+            DecodeColor(bc3 ? blocks + 8 : blocks, bc3, palette, colorIndices);
+
+            unsigned char alphas[8];
+            uint64_t alphaIndices = 0;
+            if (bc3)
+                DecodeAlpha(blocks, alphas, alphaIndices);
+
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+            {
+                for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+                {
+                    const int i = y * 4 + x;
+                    unsigned char * texel = &rgba[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4];
+                    std::memcpy(texel, palette[(colorIndices >> (2 * i)) & 3], 4);
+                    if (bc3)
+                        texel[3] = alphas[(alphaIndices >> (3 * i)) & 7];
+                }
+            }
+        }
+    }
+    return rgba;
+}
+
+double BlockPsnr(const unsigned char * original, int channels, const unsigned char * rgba, int width, int height)
+{
+    double squared = 0.0;
+    const size_t texels = (size_t)width * height;
+    for (size_t i = 0; i < texels; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            const double difference = (double)original[i * channels + c] - rgba[i * 4 + c];
+            squared += difference * difference;
+        }
+    }
+
+    if (squared == 0.0)
+        return std::numeric_limits<double>::infinity();
+    const double mse = squared / (texels * channels);
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
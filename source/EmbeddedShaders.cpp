@@ -0,0 +1,114 @@
+//
+//  EmbeddedShaders.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "EmbeddedShaders.h"
+#include "EmbeddedShaderData.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    std::string DiskDirectory;
+}
+
+const char * const EmbeddedShaders::Prefix = "embedded:";
+
+std::string EmbeddedShaders::path(ShaderResource resource)
+{
+    const EmbeddedFile& embedded = file(resource);
+    if (!DiskDirectory.empty())
+        return DiskDirectory + embedded.Path;
+    return Prefix + std::string(embedded.Path);
+}
+
+const EmbeddedFile& EmbeddedShaders::file(ShaderResource resource)
+{
+    return EmbeddedShaderData::Files[static_cast<size_t>(resource)];
+}
+
+const EmbeddedFile* EmbeddedShaders::find(const std::string& path)
+{
+    if (!isEmbedded(path))
+        return nullptr;
+
+    // A handful of files; a linear scan beats building an index
+    const std::string normalized = normalize(path);
+    const char * relative = normalized.c_str() + std::strlen(Prefix);
+    for (const EmbeddedFile& embedded : EmbeddedShaderData::Files)
+    {
+        if (std::strcmp(relative, embedded.Path) == 0)
+            return &embedded;
+    }
+    return nullptr;
+}
+
+bool EmbeddedShaders::isEmbedded(const std::string& path)
+{
+    return path.compare(0, std::strlen(Prefix), Prefix) == 0;
+}
+
+std::string EmbeddedShaders::normalize(const std::string& path)
+{
+    // Disk paths are left to the file system (symlinks, absolute paths)
+    if (!isEmbedded(path))
+        return path;
+
+    // The prefix has no slash of its own, so split what follows it
+    const std::string relative = path.substr(std::strlen(Prefix));
+
+    std::vector<std::string> parts;
+    std::string::size_type start = 0;
+    while (start <= relative.size())
+    {
+        std::string::size_type slash = relative.find('/', start);
+        if (slash == std::string::npos)
+            slash = relative.size();
+
+        const std::string part = relative.substr(start, slash - start);
+        if (part == "..")
+        {
+            if (!parts.empty() && parts.back() != "..")
+                parts.pop_back();
+            else
+                parts.push_back(part);
+        }
+        else if (!part.empty() && part != ".")
+        {
+            parts.push_back(part);
+        }
+        start = slash + 1;
+    }
+
+    std::string normalized = Prefix;
+    const size_t root = normalized.size();
+    for (const std::string& part : parts)
+    {
+        if (normalized.size() > root)
+            normalized += '/';
+        normalized += part;
+    }
+    return normalized;
+}
+
+void EmbeddedShaders::loadFromDisk(const std::string& directory)
+{
+    DiskDirectory = directory;
+    if (!DiskDirectory.empty() && DiskDirectory.back() != '/')
+        DiskDirectory += '/';
+}
+
+void EmbeddedShaders::useEmbedded()
+{
+    DiskDirectory.clear();
+}
+
+bool EmbeddedShaders::isLoadingFromDisk()
+{
+    return !DiskDirectory.empty();
+}
@@ -0,0 +1,84 @@
+//
+//  GLDeletionQueue.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/22/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "GLDeletionQueue.h"
+#include "GLState.h"
+
+GLDeletionQueue GLDeletions;
+
+void GLDeletionQueue::deleteProgram(GLuint program)
+{
+    Queue(Programs, program);
+}
+
+void GLDeletionQueue::deleteBuffer(GLuint buffer)
+{
+    Queue(Buffers, buffer);
+}
+
+void GLDeletionQueue::deleteVertexArray(GLuint vao)
+{
+    Queue(VertexArrays, vao);
+}
+
+void GLDeletionQueue::deleteTexture(GLuint texture)
+{
+    Queue(Textures, texture);
+}
+
+size_t GLDeletionQueue::flush()
+{
+    // Swap out under the lock; the GL calls run without it
+    std::vector<GLuint> programs, buffers, vertexArrays, textures;
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        programs.swap(Programs);
+        buffers.swap(Buffers);
+        vertexArrays.swap(VertexArrays);
+        textures.swap(Textures);
+    }
+
+    // The names become free for reuse, so the state cache must forget them first
+    for (GLuint program : programs)
+    {
+        GLState.onDeleteProgram(program);
+        glDeleteProgram(program);
+    }
+
+    for (GLuint buffer : buffers)
+        GLState.onDeleteBuffer(buffer);
+    if (!buffers.empty())
+        glDeleteBuffers((GLsizei)buffers.size(), buffers.data());
+
+    for (GLuint vao : vertexArrays)
+        GLState.onDeleteVertexArray(vao);
+    if (!vertexArrays.empty())
+        glDeleteVertexArrays((GLsizei)vertexArrays.size(), vertexArrays.data());
+
+    for (GLuint texture : textures)
+        GLState.onDeleteTexture(texture);
+    if (!textures.empty())
+        glDeleteTextures((GLsizei)textures.size(), textures.data());
+
+    return programs.size() + buffers.size() + vertexArrays.size() + textures.size();
+}
+
+size_t GLDeletionQueue::pending() const
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    return Programs.size() + Buffers.size() + VertexArrays.size() + Textures.size();
+}
+
+void GLDeletionQueue::Queue(std::vector<GLuint>& queue, GLuint id)
+{
+    if (!id)
+        return;
+
+    std::lock_guard<std::mutex> guard(Lock);
+    queue.push_back(id);
+}
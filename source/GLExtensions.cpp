@@ -0,0 +1,69 @@
+//
+//  GLExtensions.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/4/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "GLExtensions.h"
+
+#include <cstring>
+
+GLExtensions GLExt;
+
+bool HasGLExtension(const char * name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char * extension = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+void LoadGLExtensions(GLADloadproc load)
+{
+    GLExt = GLExtensions();
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    const int version = major * 10 + minor;
+
+    // Program binaries
+    /*---------------------------------*/
+    if (version >= 41 || HasGLExtension("GL_ARB_get_program_binary"))
+    {
+        GLExt.GetProgramBinary    = (PFNGLEXTGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+        GLExt.ProgramBinary       = (PFNGLEXTPROGRAMBINARYPROC)load("glProgramBinary");
+        GLExt.ProgramParameteri   = (PFNGLEXTPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        GLExt.HasProgramBinary = GLExt.GetProgramBinary && GLExt.ProgramBinary
+                              && GLExt.ProgramParameteri && formats > 0;
+    }
+    
+    // Parallel shader compile (completion status queries)
+    /*---------------------------------*/
+    if (HasGLExtension("GL_KHR_parallel_shader_compile"))
+    {
+        GLExt.MaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsKHR");
+        GLExt.HasParallelShaderCompile = GLExt.MaxShaderCompilerThreads != nullptr;
+    }
+    else if (HasGLExtension("GL_ARB_parallel_shader_compile"))
+    {
+        GLExt.MaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsARB");
+        GLExt.HasParallelShaderCompile = GLExt.MaxShaderCompilerThreads != nullptr;
+    }
+
+    // BC1-3 textures (enums only, uploads go through core glCompressedTexImage2D)
+    /*---------------------------------*/
+    GLExt.HasTextureCompressionS3TC = HasGLExtension("GL_EXT_texture_compression_s3tc");
+}
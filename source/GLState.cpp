@@ -0,0 +1,255 @@
+//
+//  GLState.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/16/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "GLState.h"
+
+#include <initializer_list>
+
+GLStateCache GLState;
+
+GLStateCache::GLStateCache()
+{
+    invalidate();
+}
+
+bool GLStateCache::Changed(GLuint& cached, GLuint value)
+{
+    if (cached == value)
+    {
+        ++Frame.Filtered;
+        return false;
+    }
+    cached = value;
+    ++Frame.Issued;
+    return true;
+}
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (Changed(Program, program))
+        glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+    if (Changed(VertexArray, vao))
+    {
+        glBindVertexArray(vao);
+        ElementBuffer = UNKNOWN;
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint* slot = BufferSlot(target);
+    if (!slot)
+    {
+        ++Frame.Issued;
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (Changed(*slot, buffer))
+        glBindBuffer(target, buffer);
+}
+
+void GLStateCache::activeTexture(GLenum unit)
+{
+    if (Changed(ActiveUnit, unit - GL_TEXTURE0))
+        glActiveTexture(unit);
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    const int index = TargetIndex(target);
+    if (index < 0 || ActiveUnit >= (GLuint)TEXTURE_UNITS)
+    {
+        ++Frame.Issued;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (Changed(Textures[ActiveUnit][index], texture))
+        glBindTexture(target, texture);
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    // Skip the unit switch too when the texture is already there
+    const int index = TargetIndex(target);
+    if (index >= 0 && unit < (GLuint)TEXTURE_UNITS && Textures[unit][index] == texture)
+    {
+        ++Frame.Filtered;
+        return;
+    }
+
+    activeTexture(GL_TEXTURE0 + unit);
+    bindTexture(target, texture);
+}
+
+void GLStateCache::enable(GLenum capability)
+{
+    GLuint* slot = CapabilitySlot(capability);
+    if (!slot)
+    {
+        ++Frame.Issued;
+        glEnable(capability);
+        return;
+    }
+
+    if (Changed(*slot, GL_TRUE))
+        glEnable(capability);
+}
+
+void GLStateCache::disable(GLenum capability)
+{
+    GLuint* slot = CapabilitySlot(capability);
+    if (!slot)
+    {
+        ++Frame.Issued;
+        glDisable(capability);
+        return;
+    }
+
+    if (Changed(*slot, GL_FALSE))
+        glDisable(capability);
+}
+
+void GLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+    if (BlendSource == source && BlendDestination == destination)
+    {
+        ++Frame.Filtered;
+        return;
+    }
+    BlendSource      = source;
+    BlendDestination = destination;
+    ++Frame.Issued;
+    glBlendFunc(source, destination);
+}
+
+void GLStateCache::depthFunc(GLenum function)
+{
+    if (Changed(DepthFunction, function))
+        glDepthFunc(function);
+}
+
+void GLStateCache::depthMask(GLboolean write)
+{
+    if (Changed(DepthWrite, write))
+        glDepthMask(write);
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    if (Viewport[0] == x && Viewport[1] == y && Viewport[2] == width && Viewport[3] == height)
+    {
+        ++Frame.Filtered;
+        return;
+    }
+    Viewport[0] = x;
+    Viewport[1] = y;
+    Viewport[2] = width;
+    Viewport[3] = height;
+    ++Frame.Issued;
+    glViewport(x, y, width, height);
+}
+
+void GLStateCache::onDeleteProgram(GLuint program)
+{
+    if (Program == program)
+        Program = UNKNOWN;
+}
+
+void GLStateCache::onDeleteVertexArray(GLuint vao)
+{
+    if (VertexArray == vao)
+    {
+        VertexArray   = 0;
+        ElementBuffer = UNKNOWN;
+    }
+}
+
+void GLStateCache::onDeleteBuffer(GLuint buffer)
+{
+    for (GLuint* slot : { &ArrayBuffer, &ElementBuffer, &UniformBlockBuffer, &PixelUnpackBuffer })
+        if (*slot == buffer)
+            *slot = 0;
+}
+
+void GLStateCache::onDeleteTexture(GLuint texture)
+{
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit)
+        for (int target = 0; target < TEXTURE_TARGETS; ++target)
+            if (Textures[unit][target] == texture)
+                Textures[unit][target] = 0;
+}
+
+void GLStateCache::invalidate()
+{
+    Program            = UNKNOWN;
+    VertexArray        = UNKNOWN;
+    ArrayBuffer        = UNKNOWN;
+    ElementBuffer      = UNKNOWN;
+    UniformBlockBuffer = UNKNOWN;
+    PixelUnpackBuffer  = UNKNOWN;
+    ActiveUnit         = UNKNOWN;
+
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit)
+        for (int target = 0; target < TEXTURE_TARGETS; ++target)
+            Textures[unit][target] = UNKNOWN;
+
+    Blend            = UNKNOWN;
+    DepthTest        = UNKNOWN;
+    CullFace         = UNKNOWN;
+    BlendSource      = UNKNOWN;
+    BlendDestination = UNKNOWN;
+    DepthFunction    = UNKNOWN;
+    DepthWrite       = UNKNOWN;
+    Viewport[0] = Viewport[1] = Viewport[2] = Viewport[3] = -1;
+}
+
+void GLStateCache::beginFrame()
+{
+    Previous = Frame;
+    Frame    = GLStateCounters();
+}
+
+GLuint* GLStateCache::BufferSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:         return &ArrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return &ElementBuffer;
+        case GL_UNIFORM_BUFFER:       return &UniformBlockBuffer;
+        case GL_PIXEL_UNPACK_BUFFER:  return &PixelUnpackBuffer;
+        default:                      return nullptr;
+    }
+}
+
+GLuint* GLStateCache::CapabilitySlot(GLenum capability)
+{
+    switch (capability)
+    {
+        case GL_BLEND:      return &Blend;
+        case GL_DEPTH_TEST: return &DepthTest;
+        case GL_CULL_FACE:  return &CullFace;
+        default:            return nullptr;
+    }
+}
+
+int GLStateCache::TargetIndex(GLenum target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:       return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_CUBE_MAP: return 2;
+        default:                  return -1;
+    }
+}
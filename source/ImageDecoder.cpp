@@ -0,0 +1,231 @@
+//
+//  ImageDecoder.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/17/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "PixelUpload.h"
+#include "ThreadPool.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // stbi's own luma weights, so conversions match stbi_load's
+    inline unsigned char Luma(const unsigned char * texel)
+    {
+        return (unsigned char)((texel[0] * 77 + texel[1] * 150 + texel[2] * 29) >> 8);
+    }
+
+    // One row, In channels to Out, following stbi__convert_format
+    template <int In, int Out>
+    void ConvertRow(const unsigned char * in, unsigned char * out, int width)
+    {
+        for (int x = 0; x < width; ++x, in += In, out += Out)
+        {
+            const unsigned char grey  = In >= 3 ? Luma(in) : in[0];
+            const unsigned char alpha = In == 2 ? in[1] : In == 4 ? in[3] : 255;
+
+            if (Out <= 2)
+            {
+                out[0] = grey;
+            }
+            else
+            {
+                out[0] = In >= 3 ? in[0] : grey;
+                out[1] = In >= 3 ? in[1] : grey;
+                out[2] = In >= 3 ? in[2] : grey;
+            }
+            if (Out == 2 || Out == 4)
+                out[Out - 1] = alpha;
+        }
+    }
+
+    // The common case has a shuffle kernel of its own
+    template <>
+    void ConvertRow<3, 4>(const unsigned char * in, unsigned char * out, int width)
+    {
+        ExpandRGBToRGBA(in, out, (size_t)width);
+    }
+
+    typedef void (*RowConverter)(const unsigned char *, unsigned char *, int);
+
+    const RowConverter CONVERTERS[4][4] =
+    {
+        { nullptr,          ConvertRow<1, 2>, ConvertRow<1, 3>, ConvertRow<1, 4> },
+        { ConvertRow<2, 1>, nullptr,          ConvertRow<2, 3>, ConvertRow<2, 4> },
+        { ConvertRow<3, 1>, ConvertRow<3, 2>, nullptr,          ConvertRow<3, 4> },
+        { ConvertRow<4, 1>, ConvertRow<4, 2>, ConvertRow<4, 3>, nullptr          },
+    };
+}
+
+// DecodedPixels
+/*---------------------------------*/
+void DecodedPixels::StbiDeleter::operator()(unsigned char * pixels) const
+{
+    stbi_image_free(pixels);
+}
+
+void DecodedPixels::writeRows(unsigned char * destination, size_t stride) const
+{
+    const size_t inBytes  = (size_t)Width * FileChannels;
+    const size_t outBytes = rowBytes();
+    if (stride == 0)
+        stride = outBytes;
+
+    const RowConverter convert = CONVERTERS[FileChannels - 1][Channels - 1];
+    for (int y = 0; y < Height; ++y)
+    {
+        const unsigned char * in = Source.get() + (size_t)(Flip ? Height - 1 - y : y) * inBytes;
+        unsigned char * out = destination + (size_t)y * stride;
+        if (convert)
+            convert(in, out, Width);
+        else
+            std::memcpy(out, in, outBytes);
+    }
+}
+
+const unsigned char * DecodedPixels::data()
+{
+    if (Output || !Source)
+        return Output;
+
+    if (Channels != FileChannels)
+    {
+        Converted.resize(size());
+        writeRows(Converted.data());
+        Output = Converted.data();
+        return Output;
+    }
+
+    // Same channels: swap rows pairwise where they are
+    if (Flip)
+    {
+        const size_t bytes = rowBytes();
+        unsigned char * pixels = Source.get();
+        for (int top = 0, bottom = Height - 1; top < bottom; ++top, --bottom)
+            std::swap_ranges(pixels + (size_t)top * bytes, pixels + (size_t)top * bytes + bytes,
+                             pixels + (size_t)bottom * bytes);
+        Flip = false;
+    }
+    Output = Source.get();
+    return Output;
+}
+
+// ImageDecoder
+/*---------------------------------*/
+DecodedPixels ImageDecoder::decode(const void * data, size_t size, const ImageDecodeOptions& options)
+{
+    DecodedPixels image;
+    if (options.Channels < 0 || options.Channels > 4)
+    {
+        image.Error = "channel count must be 0 to 4";
+        return image;
+    }
+
+    // stbi's JPEG decoder writes any channel count straight from its
+    // colour conversion; everything else converts in writeRows
+    const stbi_uc * bytes = static_cast<const stbi_uc *>(data);
+    const bool jpeg = size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xD8;
+
+    int requested = options.Channels;
+    int width, height, channels;
+    if (jpeg && !requested && options.ExpandRGB &&
+        stbi_info_from_memory(bytes, (int)size, &width, &height, &channels) && channels == 3)
+        requested = 4;
+
+    // Overrides any global flip for this thread; the flip is ours
+    stbi_set_flip_vertically_on_load_thread(0);
+    image.Source.reset(stbi_load_from_memory(bytes, (int)size, &width, &height, &channels,
+                                             jpeg ? requested : 0));
+    if (!image.Source)
+    {
+        const char * reason = stbi_failure_reason();
+        image.Error = reason ? reason : "decode failed";
+        return image;
+    }
+
+    image.Width        = width;
+    image.Height       = height;
+    if (!requested && options.ExpandRGB && channels == 3)
+        requested = 4;
+
+    image.FileChannels = jpeg && requested ? requested : channels;
+    image.Channels     = requested ? requested : channels;
+    image.Flip         = options.FlipVertically;
+    return image;
+}
+
+DecodedPixels ImageDecoder::decodeFile(const std::string& path, const ImageDecodeOptions& options)
+{
+    MappedFile file(path);
+    if (!file.isOpen())
+    {
+        DecodedPixels image;
+        image.Error = file.error();
+        return image;
+    }
+    return decode(file.data(), file.size(), options);
+}
+
+bool ImageDecoder::isHdr(const void * data, size_t size)
+{
+    return stbi_is_hdr_from_memory(static_cast<const stbi_uc *>(data), (int)size) != 0;
+}
+
+HalfPixels ImageDecoder::decodeHalf(const void * data, size_t size, const ImageDecodeOptions& options, ThreadPool * pool)
+{
+    HalfPixels image;
+    if (options.Channels < 0 || options.Channels > 4)
+    {
+        image.Error = "channel count must be 0 to 4";
+        return image;
+    }
+
+    const stbi_uc * bytes = static_cast<const stbi_uc *>(data);
+    int requested = options.Channels;
+    int width, height, channels;
+    if (!requested && options.ExpandRGB &&
+        stbi_info_from_memory(bytes, (int)size, &width, &height, &channels) && channels == 3)
+        requested = 4;
+
+    // stbi converts channels (alpha 1) as it decodes; the flip is ours
+    stbi_set_flip_vertically_on_load_thread(0);
+    std::unique_ptr<float, void (*)(void *)> floats(
+        stbi_loadf_from_memory(bytes, (int)size, &width, &height, &channels, requested), stbi_image_free);
+    if (!floats)
+    {
+        const char * reason = stbi_failure_reason();
+        image.Error = reason ? reason : "decode failed";
+        return image;
+    }
+
+    image.Width    = width;
+    image.Height   = height;
+    image.Channels = requested ? requested : channels;
+    image.Data.resize((size_t)width * height * image.Channels);
+
+    const size_t values = (size_t)width * image.Channels;
+    const bool flip = options.FlipVertically;
+    auto convertRows = [&](size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            const size_t from = flip ? (size_t)height - 1 - y : y;
+            FloatToHalf(floats.get() + from * values, image.Data.data() + y * values, values);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor((size_t)height, convertRows);
+    else
+        convertRows(0, (size_t)height);
+    return image;
+}
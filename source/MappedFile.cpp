@@ -0,0 +1,104 @@
+//
+//  MappedFile.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/18/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "MappedFile.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        Error = std::strerror(errno);
+        return;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        Error = std::strerror(errno);
+        ::close(fd);
+        return;
+    }
+
+    if (!S_ISREG(info.st_mode))
+    {
+        Error = "Not a regular file";
+        ::close(fd);
+        return;
+    }
+
+    // mmap rejects zero-length mappings; an empty file is still a valid file
+    Size = (size_t)info.st_size;
+    if (Size > 0)
+    {
+        int flags = MAP_PRIVATE;
+        #ifdef MAP_POPULATE
+            // Shaders are read front to back right away; fault it all in at once
+            flags |= MAP_POPULATE;
+        #endif
+        void * mapping = ::mmap(NULL, Size, PROT_READ, flags, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            Error = std::strerror(errno);
+            Size  = 0;
+            ::close(fd);
+            return;
+        }
+        Data = static_cast<const char *>(mapping);
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    Open = true;
+}
+
+MappedFile::~MappedFile()
+{
+    Release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : Data(other.Data), Size(other.Size), Open(other.Open), Error(std::move(other.Error))
+{
+    other.Data = nullptr;
+    other.Size = 0;
+    other.Open = false;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        Data  = other.Data;
+        Size  = other.Size;
+        Open  = other.Open;
+        Error = std::move(other.Error);
+        other.Data = nullptr;
+        other.Size = 0;
+        other.Open = false;
+    }
+    return *this;
+}
+
+void MappedFile::Release()
+{
+    if (Data)
+        ::munmap(const_cast<char *>(Data), Size);
+    Data = nullptr;
+    Size = 0;
+    Open = false;
+}
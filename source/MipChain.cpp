@@ -0,0 +1,318 @@
+//
+//  MipChain.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "MipChain.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/color_space.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define MIP_CHAIN_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+TextureLevel MipImage::level() const
+{
+    TextureLevel level;
+    level.Width  = Width;
+    level.Height = Height;
+    level.Data   = Pixels.data();
+    level.Size   = Pixels.size();
+    return level;
+}
+
+namespace
+{
+    // Every working level is RGBA floats whatever the channel count, so
+    // a texel is exactly one register
+    struct FloatImage
+    {
+        int Width  = 0;
+        int Height = 0;
+        std::vector<float> Texels;
+
+        void resize(int width, int height)
+        {
+            Width  = width;
+            Height = height;
+            Texels.resize((size_t)width * height * 4);
+        }
+
+        float * texel(int x, int y)             { return &Texels[((size_t)y * Width + x) * 4]; }
+        const float * texel(int x, int y) const { return &Texels[((size_t)y * Width + x) * 4]; }
+    };
+
+    // Texel arithmetic
+    /*---------------------------------*/
+    #if MIP_CHAIN_SSE2
+        typedef __m128 Texel;
+
+        inline Texel Zero()                           { return _mm_setzero_ps(); }
+        inline Texel Load(const float * p)            { return _mm_loadu_ps(p); }
+        inline void  Store(float * p, Texel t)        { _mm_storeu_ps(p, t); }
+        inline Texel Add(Texel a, Texel b)            { return _mm_add_ps(a, b); }
+        inline Texel Scale(Texel a, float s)          { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+        inline Texel MultiplyAdd(Texel sum, Texel a, float s) { return _mm_add_ps(sum, _mm_mul_ps(a, _mm_set1_ps(s))); }
+    #else
+        struct Texel { float V[4]; };
+
+        inline Texel Zero()                           { return Texel{ { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+        inline Texel Load(const float * p)            { return Texel{ { p[0], p[1], p[2], p[3] } }; }
+        inline void  Store(float * p, Texel t)        { std::copy(t.V, t.V + 4, p); }
+        inline Texel Add(Texel a, Texel b)            { for (int i = 0; i < 4; ++i) a.V[i] += b.V[i]; return a; }
+        inline Texel Scale(Texel a, float s)          { for (int i = 0; i < 4; ++i) a.V[i] *= s; return a; }
+        inline Texel MultiplyAdd(Texel sum, Texel a, float s) { for (int i = 0; i < 4; ++i) sum.V[i] += a.V[i] * s; return sum; }
+    #endif
+
+    // Colour space
+    /*---------------------------------*/
+    const float * SrgbToLinear()
+    {
+        static const std::vector<float> table = []
+        {
+            std::vector<float> values(256);
+            for (int i = 0; i < 256; ++i)
+                values[i] = glm::convertSRGBToLinear(glm::vec3(i / 255.0f)).x;
+            return values;
+        }();
+        return table.data();
+    }
+
+    // Indexed by linear value * 65535; fine enough that dark values,
+    // where sRGB steps are smallest in linear terms, still round right
+    const unsigned char * LinearToSrgb()
+    {
+        static const std::vector<unsigned char> table = []
+        {
+            std::vector<unsigned char> values(65536);
+            for (int i = 0; i < 65536; ++i)
+                values[i] = (unsigned char)(glm::convertLinearToSRGB(glm::vec3(i / 65535.0f)).x * 255.0f + 0.5f);
+            return values;
+        }();
+        return table.data();
+    }
+
+    // Which channels carry colour: RGB, or the grey of grey(+alpha)
+    bool IsColor(int channel, int channels)
+    {
+        return channels >= 3 ? channel < 3 : channel == 0;
+    }
+
+    void RunRows(ThreadPool * pool, size_t rows, const std::function<void(size_t, size_t)>& body)
+    {
+        if (pool)
+            pool->parallelFor(rows, body);
+        else
+            body(0, rows);
+    }
+
+    void ToFloat(const unsigned char * pixels, int channels, bool srgb, FloatImage& image, size_t begin, size_t end)
+    {
+        const float * linear = SrgbToLinear();
+        for (size_t y = begin; y < end; ++y)
+        {
+            const unsigned char * in = pixels + y * image.Width * channels;
+            float * out = image.texel(0, (int)y);
+            for (int x = 0; x < image.Width; ++x, in += channels, out += 4)
+            {
+                out[0] = out[1] = out[2] = out[3] = 0.0f;
+                for (int c = 0; c < channels; ++c)
+                    out[c] = srgb && IsColor(c, channels) ? linear[in[c]] : in[c] * (1.0f / 255.0f);
+            }
+        }
+    }
+
+    void ToBytes(const FloatImage& image, int channels, bool srgb, unsigned char * pixels, size_t begin, size_t end)
+    {
+        const unsigned char * encode = LinearToSrgb();
+        for (size_t y = begin; y < end; ++y)
+        {
+            const float * in = image.texel(0, (int)y);
+            unsigned char * out = pixels + y * image.Width * channels;
+            for (int x = 0; x < image.Width; ++x, in += 4, out += channels)
+            {
+                for (int c = 0; c < channels; ++c)
+                {
+                    // Kaiser lobes overshoot; clamp before either lookup or rounding
+                    const float value = std::min(std::max(in[c], 0.0f), 1.0f);
+                    out[c] = srgb && IsColor(c, channels) ? encode[(int)(value * 65535.0f + 0.5f)]
+                                                          : (unsigned char)(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+
+    // Box
+    /*---------------------------------*/
+    void BoxRows(const FloatImage& source, FloatImage& target, size_t begin, size_t end)
+    {
+        for (size_t y = begin; y < end; ++y)
+        {
+            const int y0 = std::min(2 * (int)y,     source.Height - 1);
+            const int y1 = std::min(2 * (int)y + 1, source.Height - 1);
+            for (int x = 0; x < target.Width; ++x)
+            {
+                const int x0 = std::min(2 * x,     source.Width - 1);
+                const int x1 = std::min(2 * x + 1, source.Width - 1);
+                const Texel sum = Add(Add(Load(source.texel(x0, y0)), Load(source.texel(x1, y0))),
+                                      Add(Load(source.texel(x0, y1)), Load(source.texel(x1, y1))));
+                Store(target.texel(x, (int)y), Scale(sum, 0.25f));
+            }
+        }
+    }
+
+    // Kaiser
+    /*---------------------------------*/
+    const int KAISER_TAPS = 12;
+
+    // Weights for source texels 2x-5 ... 2x+6 around target texel x,
+    // whose centre is at source coordinate 2x+1
+    const float * KaiserWeights()
+    {
+        static const std::vector<float> weights = []
+        {
+            const double alpha = 4.0, width = 3.0, pi = 3.14159265358979323846;
+            auto bessel = [](double x)
+            {
+                // I0 series; converges long before 25 terms for these arguments
+                double sum = 1.0, term = 1.0;
+                for (int k = 1; k < 25; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+                return sum;
+            };
+
+            std::vector<float> values(KAISER_TAPS);
+            double total = 0.0;
+            for (int i = 0; i < KAISER_TAPS; ++i)
+            {
+                const double t = (i - 5.5) / 2.0;      // in target texels
+                const double sinc = std::sin(pi * t) / (pi * t);
+                const double ratio = t / width;
+                const double window = bessel(alpha * std::sqrt(1.0 - ratio * ratio)) / bessel(alpha);
+                values[i] = (float)(sinc * window);
+                total += values[i];
+            }
+            for (float& value : values)
+                value = (float)(value / total);
+            return values;
+        }();
+        return weights.data();
+    }
+
+    // Horizontal pass: source rows -> target width
+    void KaiserRowsX(const FloatImage& source, FloatImage& target, size_t begin, size_t end)
+    {
+        const float * weights = KaiserWeights();
+        for (size_t y = begin; y < end; ++y)
+        {
+            for (int x = 0; x < target.Width; ++x)
+            {
+                Texel sum = Zero();
+                for (int i = 0; i < KAISER_TAPS; ++i)
+                {
+                    const int sx = std::min(std::max(2 * x + i - 5, 0), source.Width - 1);
+                    sum = MultiplyAdd(sum, Load(source.texel(sx, (int)y)), weights[i]);
+                }
+                Store(target.texel(x, (int)y), sum);
+            }
+        }
+    }
+
+    // Vertical pass: target width, source rows -> target rows
+    void KaiserRowsY(const FloatImage& source, FloatImage& target, size_t begin, size_t end)
+    {
+        const float * weights = KaiserWeights();
+        for (size_t y = begin; y < end; ++y)
+        {
+            for (int x = 0; x < target.Width; ++x)
+            {
+                Texel sum = Zero();
+                for (int i = 0; i < KAISER_TAPS; ++i)
+                {
+                    const int sy = std::min(std::max(2 * (int)y + i - 5, 0), source.Height - 1);
+                    sum = MultiplyAdd(sum, Load(source.texel(x, sy)), weights[i]);
+                }
+                Store(target.texel(x, (int)y), sum);
+            }
+        }
+    }
+}
+
+std::vector<MipImage> GenerateMipChain(const unsigned char * pixels, int width, int height, int channels,
+                                       const MipOptions& options)
+{
+    ThreadPool * pool = options.Pool;
+
+    // Float levels, top first
+    std::vector<FloatImage> levels(1);
+    levels[0].resize(width, height);
+    RunRows(pool, height, [&](size_t begin, size_t end)
+    {
+        ToFloat(pixels, channels, options.Srgb, levels[0], begin, end);
+    });
+
+    FloatImage horizontal;
+    while (levels.back().Width > 1 || levels.back().Height > 1)
+    {
+        levels.emplace_back();
+        const FloatImage& source = levels[levels.size() - 2];
+        FloatImage& target = levels.back();
+        target.resize(std::max(1, source.Width / 2), std::max(1, source.Height / 2));
+
+        if (options.Filter == MipFilter::Kaiser)
+        {
+            horizontal.resize(target.Width, source.Height);
+            RunRows(pool, source.Height, [&](size_t begin, size_t end) { KaiserRowsX(source, horizontal, begin, end); });
+            RunRows(pool, target.Height, [&](size_t begin, size_t end) { KaiserRowsY(horizontal, target, begin, end); });
+        }
+        else
+        {
+            RunRows(pool, target.Height, [&](size_t begin, size_t end) { BoxRows(source, target, begin, end); });
+        }
+    }
+
+    // Level 0 is the input as it was; every other level's rows go back
+    // to 8 bits together
+    std::vector<MipImage> chain(levels.size());
+    std::vector<std::pair<size_t, int>> rows;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        chain[i].Width    = levels[i].Width;
+        chain[i].Height   = levels[i].Height;
+        chain[i].Channels = channels;
+        if (i == 0)
+        {
+            chain[0].Pixels.assign(pixels, pixels + (size_t)width * height * channels);
+            continue;
+        }
+
+        chain[i].Pixels.resize((size_t)levels[i].Width * levels[i].Height * channels);
+        for (int y = 0; y < levels[i].Height; ++y)
+            rows.push_back(std::make_pair(i, y));
+    }
+
+    RunRows(pool, rows.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t row = begin; row < end; ++row)
+        {
+            const size_t level = rows[row].first;
+            const size_t y = (size_t)rows[row].second;
+            ToBytes(levels[level], channels, options.Srgb, chain[level].Pixels.data(), y, y + 1);
+        }
+    });
+    return chain;
+}
@@ -0,0 +1,217 @@
+//
+//  PixelUpload.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "PixelUpload.h"
+
+#include <glm/gtc/packing.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define PIXEL_UPLOAD_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// Builds without -mssse3 (the x86-64 default) still get the shuffle:
+// just that kernel is compiled for SSSE3, and used if the CPU has it
+#if defined(__SSSE3__) || defined(__AVX__)
+    #define PIXEL_UPLOAD_SSSE3 1
+    #define PIXEL_UPLOAD_SSSE3_TARGET
+    #include <tmmintrin.h>
+#elif (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #define PIXEL_UPLOAD_SSSE3 1
+    #define PIXEL_UPLOAD_SSSE3_DISPATCH 1
+    #define PIXEL_UPLOAD_SSSE3_TARGET __attribute__((target("ssse3")))
+    #include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define PIXEL_UPLOAD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if PIXEL_UPLOAD_SSE2
+namespace
+{
+    // glm's toFloat16 on four lanes. Normal results add the rounding
+    // bit before the exponent is rebiased, so a carry out of the
+    // mantissa lands in the exponent by itself. Denormal results are
+    // round(|f| * 2^24) half up, done on the integer |f| * 2^25 (the
+    // scale is exact) so no float add can round up first. Lanes
+    // whose exponent is all ones (Inf, NaN) are left to the caller.
+    inline __m128i HalfBits(__m128 values)
+    {
+        const __m128i bits      = _mm_castps_si128(values);
+        const __m128i magnitude = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+        const __m128i sign      = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+
+        __m128i normal = _mm_add_epi32(magnitude, _mm_slli_epi32(_mm_and_si128(magnitude, _mm_set1_epi32(0x1000)), 1));
+        normal = _mm_sub_epi32(normal, _mm_set1_epi32((127 - 15) << 23));
+        const __m128i overflow = _mm_cmpgt_epi32(normal, _mm_set1_epi32((31 << 23) - 1));
+        normal = _mm_or_si128(_mm_andnot_si128(overflow, _mm_srli_epi32(normal, 13)),
+                              _mm_and_si128(overflow, _mm_set1_epi32(0x7c00)));
+
+        const __m128i scaled   = _mm_cvttps_epi32(_mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_set1_ps(33554432.0f)));
+        const __m128i denormal = _mm_srli_epi32(_mm_add_epi32(scaled, _mm_set1_epi32(1)), 1);
+        const __m128i small = _mm_cmplt_epi32(magnitude, _mm_set1_epi32(113 << 23));
+
+        const __m128i half = _mm_or_si128(_mm_andnot_si128(small, normal), _mm_and_si128(small, denormal));
+        return _mm_or_si128(half, sign);
+    }
+
+    // Sign extends the low 16 bits so the saturating pack keeps them
+    inline __m128i PackHalves(__m128i low, __m128i high)
+    {
+        low  = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+        high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+        return _mm_packs_epi32(low, high);
+    }
+}
+#endif
+
+#if PIXEL_UPLOAD_SSSE3
+namespace
+{
+    bool HasSsse3()
+    {
+    #if PIXEL_UPLOAD_SSSE3_DISPATCH
+        static const bool supported = __builtin_cpu_supports("ssse3");
+        return supported;
+    #else
+        return true;
+    #endif
+    }
+
+    // Four texels per register: 12 bytes spread over 16, alpha OR'd in.
+    // Returns the texels done, a multiple of 16.
+    PIXEL_UPLOAD_SSSE3_TARGET
+    size_t ExpandRGBToRGBASsse3(const unsigned char * rgb, unsigned char * rgba, size_t texels)
+    {
+        const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha  = _mm_set1_epi32((int)0xFF000000);
+
+        size_t i = 0;
+        for (; i + 16 <= texels; i += 16, rgb += 48, rgba += 64)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 16));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 32));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba),
+                             _mm_or_si128(_mm_shuffle_epi8(a, spread), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + 16),
+                             _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), spread), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + 32),
+                             _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), spread), alpha));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(rgba + 48),
+                             _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), spread), alpha));
+        }
+        return i;
+    }
+}
+#endif
+
+PixelFormat PixelFormatFor(int channels)
+{
+    switch (channels)
+    {
+        case 1:  return { GL_R8,    GL_RED  };
+        case 2:  return { GL_RG8,   GL_RG   };
+        case 3:  return { GL_RGB8,  GL_RGB  };
+        default: return { GL_RGBA8, GL_RGBA };
+    }
+}
+
+PixelFormat HalfFormatFor(int channels)
+{
+    switch (channels)
+    {
+        case 1:  return { GL_R16F,    GL_RED,  GL_HALF_FLOAT };
+        case 2:  return { GL_RG16F,   GL_RG,   GL_HALF_FLOAT };
+        case 3:  return { GL_RGB16F,  GL_RGB,  GL_HALF_FLOAT };
+        default: return { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT };
+    }
+}
+
+GLint UnpackAlignmentFor(size_t rowBytes, uintptr_t address)
+{
+    for (GLint alignment = 8; alignment > 1; alignment /= 2)
+    {
+        if (rowBytes % alignment == 0 && address % alignment == 0)
+            return alignment;
+    }
+    return 1;
+}
+
+void ExpandRGBToRGBA(const unsigned char * rgb, unsigned char * rgba, size_t texels)
+{
+    size_t i = 0;
+
+#if PIXEL_UPLOAD_SSSE3
+    if (HasSsse3())
+    {
+        i = ExpandRGBToRGBASsse3(rgb, rgba, texels);
+        rgb  += i * 3;
+        rgba += i * 4;
+    }
+#elif PIXEL_UPLOAD_NEON
+    // De-interleaving loads and interleaving stores do it all
+    const uint8x16_t alpha = vdupq_n_u8(255);
+    for (; i + 16 <= texels; i += 16, rgb += 48, rgba += 64)
+    {
+        const uint8x16x3_t in = vld3q_u8(rgb);
+        uint8x16x4_t out;
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        out.val[2] = in.val[2];
+        out.val[3] = alpha;
+        vst4q_u8(rgba, out);
+    }
+#endif
+
+    for (; i < texels; ++i, rgb += 3, rgba += 4)
+    {
+        rgba[0] = rgb[0];
+        rgba[1] = rgb[1];
+        rgba[2] = rgb[2];
+        rgba[3] = 255;
+    }
+}
+
+void FloatToHalf(const float * values, uint16_t * halves, size_t count)
+{
+    size_t i = 0;
+
+#if PIXEL_UPLOAD_SSE2
+    const __m128i exponent = _mm_set1_epi32(0x7f800000);
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128 low  = _mm_loadu_ps(values + i);
+        const __m128 high = _mm_loadu_ps(values + i + 4);
+
+        // Inf and NaN are rare enough to take the scalar path
+        const __m128i special = _mm_or_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(low), exponent), exponent),
+            _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(high), exponent), exponent));
+        if (_mm_movemask_epi8(special))
+        {
+            for (size_t j = i; j < i + 8; ++j)
+                halves[j] = glm::packHalf1x16(values[j]);
+            continue;
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(halves + i), PackHalves(HalfBits(low), HalfBits(high)));
+    }
+#elif PIXEL_UPLOAD_NEON
+    for (; i + 8 <= count; i += 8)
+    {
+        const float16x8_t half = vcombine_f16(vcvt_f16_f32(vld1q_f32(values + i)),
+                                              vcvt_f16_f32(vld1q_f32(values + i + 4)));
+        vst1q_u16(halves + i, vreinterpretq_u16_f16(half));
+    }
+#endif
+
+    for (; i < count; ++i)
+        halves[i] = glm::packHalf1x16(values[i]);
+}
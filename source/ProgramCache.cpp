@@ -0,0 +1,238 @@
+//
+//  ProgramCache.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/4/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ProgramCache.h"
+#include "GLExtensions.h"
+#include "Hash.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC   = 0x42504C47; // "GLPB"
+    const uint32_t CACHE_VERSION = 1;
+
+    // File layout: header followed by Length bytes of driver binary
+    struct EntryHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint64_t Key;
+        uint64_t Checksum;
+        uint32_t Format;
+        uint32_t Length;
+        double   CompileMs;
+    };
+
+    bool              Enabled = false;
+    std::string       Directory;
+    ProgramCacheStats Stats;
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string GLString(GLenum name)
+    {
+        const GLubyte * value = glGetString(name);
+        return value ? std::string((const char *)value) : std::string();
+    }
+}
+
+bool ProgramCache::enable(const std::string& directory)
+{
+    if (!GLExt.HasProgramBinary)
+    {
+        std::cerr << "WARNING::PROGRAM_CACHE::UNSUPPORTED driver has no program binary formats" << std::endl;
+        return false;
+    }
+
+    // Fine if it already exists
+    ::mkdir(directory.c_str(), 0755);
+
+    struct stat info;
+    if (::stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+    {
+        std::cerr << "ERROR::PROGRAM_CACHE::DIRECTORY_UNAVAILABLE Path=" << directory << std::endl;
+        return false;
+    }
+
+    Directory = directory;
+    Enabled   = true;
+    return true;
+}
+
+void ProgramCache::disable()
+{
+    Enabled = false;
+}
+
+bool ProgramCache::isEnabled()
+{
+    return Enabled;
+}
+
+uint64_t ProgramCache::makeKey(uint64_t vertexHash,
+                               uint64_t fragmentHash,
+                               const std::string& defines)
+{
+    uint64_t key = HashBytes(&vertexHash, sizeof(vertexHash));
+    key = HashBytes(&fragmentHash, sizeof(fragmentHash), key);
+    key = HashString(defines, key);
+    key = HashString(GLString(GL_VENDOR), key);
+    key = HashString(GLString(GL_RENDERER), key);
+    key = HashString(GLString(GL_VERSION), key);
+    return key;
+}
+
+GLuint ProgramCache::load(uint64_t key)
+{
+    if (!Enabled)
+        return 0;
+
+    const std::string path = EntryPath(key);
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        ++Stats.Misses;
+        return 0;
+    }
+    const std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    EntryHeader header;
+    std::vector<char> binary;
+    bool valid = false;
+
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header))
+        && header.Magic == CACHE_MAGIC
+        && header.Version == CACHE_VERSION
+        && header.Key == key
+        && header.Length <= (uint64_t)(fileSize - (std::streamoff)sizeof(header)))   // a corrupt Length must not allocate
+    {
+        binary.resize(header.Length);
+        valid = file.read(binary.data(), binary.size())
+             && HashBytes(binary.data(), binary.size()) == header.Checksum;
+    }
+    file.close();
+
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        GLExt.ProgramBinary(program, header.Format, binary.data(), (GLsizei)binary.size());
+
+        // The driver may still refuse a binary it produced (e.g. after an update)
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (!program)
+    {
+        std::remove(path.c_str());
+        ++Stats.Rejected;
+        ++Stats.Misses;
+        return 0;
+    }
+
+    const double loadMs = MillisecondsSince(start);
+    ++Stats.Hits;
+    Stats.LoadMs  += loadMs;
+    Stats.SavedMs += header.CompileMs - loadMs;
+    return program;
+}
+
+void ProgramCache::store(uint64_t key, GLuint program, double compileMs)
+{
+    Stats.CompileMs += compileMs;
+
+    if (!Enabled)
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLExt.GetProgramBinary(program, length, NULL, &format, binary.data());
+
+    EntryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.Magic     = CACHE_MAGIC;
+    header.Version   = CACHE_VERSION;
+    header.Key       = key;
+    header.Checksum  = HashBytes(binary.data(), binary.size());
+    header.Format    = format;
+    header.Length    = (uint32_t)binary.size();
+    header.CompileMs = compileMs;
+
+    // Write then rename so a crash never leaves a half-written entry
+    const std::string path = EntryPath(key);
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file)
+        {
+            std::cerr << "ERROR::PROGRAM_CACHE::WRITE_FAILED Path=" << temp << std::endl;
+            file.close();
+            std::remove(temp.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp.c_str());
+        return;
+    }
+    ++Stats.Stored;
+}
+
+void ProgramCache::markRetrievable(GLuint program)
+{
+    if (Enabled)
+        GLExt.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+const ProgramCacheStats& ProgramCache::stats()
+{
+    return Stats;
+}
+
+void ProgramCache::printStats(std::ostream& out)
+{
+    out << "Program cache: "
+        << Stats.Hits << " hit(s), "
+        << Stats.Misses << " miss(es) (" << Stats.Rejected << " rejected), "
+        << Stats.Stored << " stored" << std::endl
+        << "  load " << Stats.LoadMs << " ms, compile " << Stats.CompileMs << " ms, "
+        << "saved " << Stats.SavedMs << " ms" << std::endl;
+}
+
+std::string ProgramCache::EntryPath(uint64_t key)
+{
+    return Directory + "/" + HashToHex(key) + ".bin";
+}
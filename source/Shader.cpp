@@ -8,126 +8,315 @@
 
 #include <glad/3.3/glad.h>
 #include "Shader.h"
+#include "GLDeletionQueue.h"
+#include "GLState.h"
+#include "ProgramCache.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderProfiler.h"
+#include "ShaderWatcher.h"
+#include "UniformBuffer.h"
 
-Shader::Shader(const char * vertexPath, const char * fragmentPath)
+#include <chrono>
+
+namespace
 {
-    // Check file(s) exist
-    if (!FileExists(vertexPath))
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
     {
-        std::cerr << "ERROR::SHADER::VERTEX::FILE_NOT_FOUND Path=" << vertexPath << std::endl;
-        return;
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     }
+}
+
+Shader::Shader(const char * vertexPath, const char * fragmentPath, const std::vector<std::string>& defines)
+    : VertexPath(vertexPath), FragmentPath(fragmentPath), Defines(defines)
+{
+    // 1. map the vertex/fragment source code from filePath, expanding includes
+    //    (one open + mmap per file; the text is never copied)
+    PreprocessedSource vertex;
+    PreprocessedSource fragment;
     
-    if (!FileExists(fragmentPath))
+    if (!loadSources(vertex, fragment))
     {
-        std::cerr << "ERROR::SHADER::FRAGMENT::FILE_NOT_FOUND Path=" << fragmentPath << std::endl;
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         return;
     }
     
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    
-    // ensure ifstream objects can throw exceptions
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+    ID = CreateProgram(vertex, fragment);
+    OnLinked();
+}
+
+Shader::Shader(ShaderResource vertex, ShaderResource fragment, const std::vector<std::string>& defines)
+    : Shader(EmbeddedShaders::path(vertex).c_str(), EmbeddedShaders::path(fragment).c_str(), defines)
+{
+}
+
+Shader::~Shader()
+{
+    if (Watcher)
+        Watcher->unwatch(*this);
+    GLDeletions.deleteProgram(ID);
+}
+
+Shader::Shader(Shader&& other) noexcept
+    : ID(other.ID), Revision(other.Revision),
+      VertexPath(std::move(other.VertexPath)), FragmentPath(std::move(other.FragmentPath)),
+      Defines(std::move(other.Defines)), Uniforms(std::move(other.Uniforms))
+{
+    other.ID = 0;
+
+    // The watcher holds the address; hand it the new one
+    if (other.Watcher)
+        other.Watcher->Moved(other, *this);
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        // This program is going away, and with it whatever watched it
+        if (Watcher)
+            Watcher->unwatch(*this);
+
+        GLDeletions.deleteProgram(ID);
+        ID           = other.ID;
+        Revision     = other.Revision;
+        VertexPath   = std::move(other.VertexPath);
+        FragmentPath = std::move(other.FragmentPath);
+        Defines      = std::move(other.Defines);
+        Uniforms     = std::move(other.Uniforms);
+        other.ID = 0;
+
+        if (other.Watcher)
+            other.Watcher->Moved(other, *this);
+    }
+    return *this;
+}
+
+Shader::Shader(GLuint program, const std::string& vertexPath, const std::string& fragmentPath,
+               const std::vector<std::string>& defines)
+    : ID(program), VertexPath(vertexPath), FragmentPath(fragmentPath), Defines(defines)
+{
+    OnLinked();
+}
+
+bool Shader::loadSources(PreprocessedSource& vertex, PreprocessedSource& fragment, std::vector<std::string>* files,
+                         SourceFiles access) const
+{
+    if (!ShaderPreprocessor::expand(VertexPath, Defines, vertex, access) ||
+        !ShaderPreprocessor::expand(FragmentPath, Defines, fragment, access))
+        return false;
     
-    try
+    if (files)
     {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        
-        // convert stream into string
-        vertexCode   = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        files->assign(vertex.Files.begin(), vertex.Files.end());
+        files->insert(files->end(), fragment.Files.begin(), fragment.Files.end());
     }
-    catch (std::ifstream::failure e)
+    return true;
+}
+
+bool Shader::reload(const PreprocessedSource& vertex, const PreprocessedSource& fragment)
+{
+    GLuint program = CreateProgram(vertex, fragment);
+    if (!program)
     {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
-        return;
+        std::cerr << "ERROR::SHADER::RELOAD_FAILED keeping previous program Path=" << FragmentPath << std::endl;
+        return false;
     }
     
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    // Swap only once the replacement has linked; the old program is
+    // deleted with the rest at frame end
+    GLDeletions.deleteProgram(ID);
+    ID = program;
+    OnLinked();
+    ++Revision;
+    return true;
+}
+
+void Shader::OnLinked()
+{
+    if (!ID)
+        return;
+    
+    // Resolve every active uniform once so setters never hit glGetUniformLocation
+    Uniforms.build(ID);
+    
+    // Point shared uniform blocks at their registered binding points
+    UniformBlockBindings::apply(ID);
+}
+
+GLuint Shader::CreateProgram(const PreprocessedSource& vertexSource, const PreprocessedSource& fragmentSource)
+{
+    ShaderTiming timing;
+    timing.VertexPath   = VertexPath;
+    timing.FragmentPath = FragmentPath;
+    timing.Defines      = ShaderPreprocessor::joinDefines(Defines);
+    timing.ReadMs       = vertexSource.ReadMs + fragmentSource.ReadMs;
+    timing.PreprocessMs = vertexSource.PreprocessMs + fragmentSource.PreprocessMs;
+    timing.Reload       = ID != 0;
+    
+    // 2. Try the program binary cache first
+    const bool cached = ProgramCache::isEnabled();
+    uint64_t key = 0;
     
-    // 2. Compile shaders
+    if (cached)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        key = ProgramCache::makeKey(vertexSource.hash(), fragmentSource.hash(), timing.Defines);
+        GLuint program = ProgramCache::load(key);
+        timing.CacheMs = MillisecondsSince(start);
+        
+        if (program)
+        {
+            timing.CacheHit = true;
+            timing.Linked   = true;
+            ShaderProfiler::record(timing);
+            return program;
+        }
+    }
+    
+    // 3. Compile shaders; each status query waits for its compile
     unsigned int vertex, fragment;
-    int success;
-    char errlog[512];
     
     // Vertex shader
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
+    glShaderSource(vertex, (GLsizei)vertexSource.Strings.size(), vertexSource.Strings.data(), vertexSource.Lengths.data());
     glCompileShader(vertex);
     CheckCompileErrors(vertex, "VERTEX");
+    timing.VertexCompileMs = MillisecondsSince(start);
     
     // Fragment shader
+    start = std::chrono::steady_clock::now();
     fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
+    glShaderSource(fragment, (GLsizei)fragmentSource.Strings.size(), fragmentSource.Strings.data(), fragmentSource.Lengths.data());
     glCompileShader(fragment);
     CheckCompileErrors(fragment, "FRAGMENT");
+    timing.FragmentCompileMs = MillisecondsSince(start);
     
     // Shader program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
-    
-    // Check linking errors
-    CheckCompileErrors(ID, "PROGRAM");
+    start = std::chrono::steady_clock::now();
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    ProgramCache::markRetrievable(program);
+    glLinkProgram(program);
     
     // delete the shaders as they're linked into our program now and no longer necessery
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+    
+    // Check linking errors
+    timing.Linked = CheckCompileErrors(program, "PROGRAM");
+    timing.LinkMs = MillisecondsSince(start);
+    ShaderProfiler::record(timing);
+    
+    if (!timing.Linked)
+    {
+        glDeleteProgram(program);
+        return 0;
+    }
+    
+    if (cached)
+        ProgramCache::store(key, program, timing.VertexCompileMs + timing.FragmentCompileMs + timing.LinkMs);
+    
+    return program;
 }
 
 void Shader::use()
 {
-    glUseProgram(ID);
+    GLState.useProgram(ID);
+}
+
+UniformHandle Shader::getUniform(const std::string& name) const
+{
+    return Uniforms.find(name);
+}
+
+UniformHandle Shader::getUniform(uint32_t nameHash) const
+{
+    return Uniforms.find(nameHash);
 }
 
 void Shader::setBool(const std::string& name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    setBool(Uniforms.find(name), value);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setInt(Uniforms.find(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    setFloat(Uniforms.find(name), value);
 }
 
-bool Shader::FileExists(const std::string& path)
+void Shader::setBool(UniformHandle uniform, bool value) const
 {
-    if (FILE *file = ::fopen(path.c_str(), "r"))
-    {
-        fclose(file);
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    glUniform1i(uniform.Location, (int)value);
+}
+
+void Shader::setInt(UniformHandle uniform, int value) const
+{
+    glUniform1i(uniform.Location, value);
+}
+
+void Shader::setFloat(UniformHandle uniform, float value) const
+{
+    glUniform1f(uniform.Location, value);
+}
+
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const
+{
+    setVec2(Uniforms.find(name), value);
 }
 
-void Shader::CheckCompileErrors(GLuint shader, const std::string& type)
+void Shader::setVec3(const std::string& name, const glm::vec3& value) const
+{
+    setVec3(Uniforms.find(name), value);
+}
+
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const
+{
+    setVec4(Uniforms.find(name), value);
+}
+
+void Shader::setVec2(UniformHandle uniform, const glm::vec2& value) const
+{
+    setArray(uniform, &value, 1);
+}
+
+void Shader::setVec3(UniformHandle uniform, const glm::vec3& value) const
+{
+    setArray(uniform, &value, 1);
+}
+
+void Shader::setVec4(UniformHandle uniform, const glm::vec4& value) const
+{
+    setArray(uniform, &value, 1);
+}
+
+void Shader::setMat3(const std::string& name, const glm::mat3& value) const
+{
+    setMat3(Uniforms.find(name), value);
+}
+
+void Shader::setMat4(const std::string& name, const glm::mat4& value) const
+{
+    setMat4(Uniforms.find(name), value);
+}
+
+void Shader::setMat3(UniformHandle uniform, const glm::mat3& value) const
+{
+    setArray(uniform, &value, 1);
+}
+
+void Shader::setMat4(UniformHandle uniform, const glm::mat4& value) const
+{
+    setArray(uniform, &value, 1);
+}
+
+bool Shader::CheckCompileErrors(GLuint shader, const std::string& type)
 {
     GLint success;
     GLchar infoLog[1024];
@@ -158,4 +347,5 @@ void Shader::CheckCompileErrors(GLuint shader, const std::string& type)
             << std::endl;
         }
     }
-}
\ No newline at end of file
+    return success;
+}
@@ -0,0 +1,324 @@
+//
+//  ShaderLibrary.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/8/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ShaderLibrary.h"
+#include "GLExtensions.h"
+#include "Hash.h"
+#include "ProgramCache.h"
+#include "ShaderPreprocessor.h"
+
+#include <chrono>
+#include <set>
+#include <thread>
+
+namespace
+{
+    std::chrono::steady_clock::time_point Now()
+    {
+        return std::chrono::steady_clock::now();
+    }
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Now() - start).count();
+    }
+
+    GLuint CompileStage(GLenum type, const PreprocessedSource& source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, (GLsizei)source.Strings.size(), source.Strings.data(), source.Lengths.data());
+        glCompileShader(shader);
+        return shader;
+    }
+}
+
+ShaderLibrary::ShaderLibrary()
+{
+    // Let the driver use as many compiler threads as it likes
+    if (GLExt.HasParallelShaderCompile)
+        GLExt.MaxShaderCompilerThreads(0xFFFFFFFFu);
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    for (GLuint stage : Stages)
+        glDeleteShader(stage);
+    for (const PendingProgram& pending : Pending)
+        glDeleteProgram(pending.Program);
+}
+
+void ShaderLibrary::add(const ProgramDesc& desc)
+{
+    Queued.push_back(desc);
+}
+
+void ShaderLibrary::add(const std::vector<ProgramDesc>& descs)
+{
+    Queued.insert(Queued.end(), descs.begin(), descs.end());
+}
+
+void ShaderLibrary::addPermutations(const ProgramDesc& base, const std::vector<std::vector<std::string>>& defineSets)
+{
+    for (const std::vector<std::string>& defines : defineSets)
+    {
+        ProgramDesc desc = base;
+        desc.Name = permutationName(base.Name, defines);
+        desc.Defines.insert(desc.Defines.end(), defines.begin(), defines.end());
+        Queued.push_back(desc);
+    }
+}
+
+std::string ShaderLibrary::permutationName(const std::string& base, const std::vector<std::string>& defines)
+{
+    if (defines.empty())
+        return base;
+    return base + "+" + ShaderPreprocessor::joinDefines(defines, '+');
+}
+
+void ShaderLibrary::submit()
+{
+    std::chrono::steady_clock::time_point start = Now();
+    const bool cached = ProgramCache::isEnabled();
+
+    // Stage objects by content hash, shared by every program in the batch
+    std::map<uint64_t, GLuint> stages;
+
+    // 1. Expand sources, dedupe, take cache hits, compile every unique stage
+    std::vector<PendingProgram> batch;
+    batch.reserve(Queued.size());
+
+    for (const ProgramDesc& desc : Queued)
+    {
+        ++Stats.Requested;
+
+        PreprocessedSource vertex, fragment;
+        if (!ShaderPreprocessor::expand(desc.VertexPath, desc.Defines, vertex))
+        {
+            std::cerr << "ERROR::SHADER::VERTEX::FILE_NOT_SUCCESFULLY_READ Path=" << desc.VertexPath << std::endl;
+            PendingNames.erase(desc.Name);
+            UnreadNames.insert(desc.Name);
+            continue;
+        }
+        if (!ShaderPreprocessor::expand(desc.FragmentPath, desc.Defines, fragment))
+        {
+            std::cerr << "ERROR::SHADER::FRAGMENT::FILE_NOT_SUCCESFULLY_READ Path=" << desc.FragmentPath << std::endl;
+            PendingNames.erase(desc.Name);
+            UnreadNames.insert(desc.Name);
+            continue;
+        }
+
+        // Stage hashes include the type so a file can't alias across stages
+        const uint64_t vertexHash   = vertex.hash(GL_VERTEX_SHADER);
+        const uint64_t fragmentHash = fragment.hash(GL_FRAGMENT_SHADER);
+        const uint64_t content      = HashBytes(&fragmentHash, sizeof(fragmentHash), vertexHash);
+
+        PendingNames[desc.Name] = content;
+        UnreadNames.erase(desc.Name);
+
+        // Already linked, or already in this batch under another name
+        bool duplicate = Unique.count(content) > 0;
+        for (const PendingProgram& pending : Pending)
+            duplicate = duplicate || pending.Content == content;
+        for (const PendingProgram& pending : batch)
+            duplicate = duplicate || pending.Content == content;
+
+        if (duplicate)
+        {
+            ++Stats.ProgramReuses;
+            continue;
+        }
+
+        PendingProgram pending;
+        pending.Desc    = desc;
+        pending.Content = content;
+
+        ShaderTiming& timing = pending.Timing;
+        timing.VertexPath   = desc.VertexPath;
+        timing.FragmentPath = desc.FragmentPath;
+        timing.Defines      = ShaderPreprocessor::joinDefines(desc.Defines);
+        timing.ReadMs       = vertex.ReadMs + fragment.ReadMs;
+        timing.PreprocessMs = vertex.PreprocessMs + fragment.PreprocessMs;
+
+        if (cached)
+        {
+            std::chrono::steady_clock::time_point lookup = Now();
+            pending.Key     = ProgramCache::makeKey(vertex.hash(), fragment.hash(), timing.Defines);
+            pending.Program = ProgramCache::load(pending.Key);
+            pending.Cached  = pending.Program != 0;
+            timing.CacheMs  = MillisecondsSince(lookup);
+            timing.CacheHit = pending.Cached;
+        }
+
+        if (!pending.Cached)
+        {
+            for (auto stage : { std::make_pair(vertexHash, &vertex), std::make_pair(fragmentHash, &fragment) })
+            {
+                GLuint& shader = stages[stage.first];
+                if (shader)
+                {
+                    ++Stats.StageReuses;
+                }
+                else
+                {
+                    shader = CompileStage(stage.second == &vertex ? GL_VERTEX_SHADER : GL_FRAGMENT_SHADER, *stage.second);
+                    Stages.push_back(shader);
+                    ++Stats.StageCompiles;
+                }
+            }
+            pending.Vertex   = stages[vertexHash];
+            pending.Fragment = stages[fragmentHash];
+        }
+        batch.push_back(std::move(pending));
+    }
+    Queued.clear();
+
+    // 2. Link everything; still no status queries
+    for (PendingProgram& pending : batch)
+    {
+        if (pending.Cached)
+            continue;
+
+        pending.Program = glCreateProgram();
+        glAttachShader(pending.Program, pending.Vertex);
+        glAttachShader(pending.Program, pending.Fragment);
+        ProgramCache::markRetrievable(pending.Program);
+        glLinkProgram(pending.Program);
+        ++Stats.ProgramsLinked;
+    }
+
+    Pending.insert(Pending.end(),
+                   std::make_move_iterator(batch.begin()),
+                   std::make_move_iterator(batch.end()));
+    SubmitMs += MillisecondsSince(start);
+}
+
+bool ShaderLibrary::IsComplete(const PendingProgram& pending) const
+{
+    if (pending.Cached || !GLExt.HasParallelShaderCompile)
+        return true;
+
+    GLint complete = GL_TRUE;
+    glGetProgramiv(pending.Program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool ShaderLibrary::isReady() const
+{
+    for (const PendingProgram& pending : Pending)
+        if (!IsComplete(pending))
+            return false;
+    return true;
+}
+
+int ShaderLibrary::finish()
+{
+    std::chrono::steady_clock::time_point start = Now();
+
+    // 3. Wait for the driver's compiler threads
+    while (!isReady())
+        std::this_thread::yield();
+
+    // 4. Only now read back status; nothing here blocks on the compiler
+    size_t compiled = 0;
+    for (const PendingProgram& pending : Pending)
+        compiled += pending.Cached ? 0 : 1;
+
+    const double compileMs = compiled ? (SubmitMs + MillisecondsSince(start)) / compiled : 0.0;
+
+    // Each unique stage reports its own errors once
+    for (GLuint stage : Stages)
+    {
+        GLint type = 0;
+        glGetShaderiv(stage, GL_SHADER_TYPE, &type);
+        Shader::CheckCompileErrors(stage, type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT");
+    }
+
+    for (PendingProgram& pending : Pending)
+    {
+        // Compiles overlap, so per-stage times don't exist; report the average
+        ShaderTiming& timing = pending.Timing;
+        timing.Batched = !pending.Cached;
+        timing.LinkMs  = pending.Cached ? 0.0 : compileMs;
+        timing.Linked  = pending.Cached || Shader::CheckCompileErrors(pending.Program, "PROGRAM");
+        ShaderProfiler::record(timing);
+
+        if (!timing.Linked)
+        {
+            std::cerr << "ERROR::SHADER_LIBRARY::PROGRAM_FAILED Name=" << pending.Desc.Name << std::endl;
+            glDeleteProgram(pending.Program);
+            continue;
+        }
+
+        // Batched compiles overlap, so the per-program time is the batch average
+        if (!pending.Cached && ProgramCache::isEnabled())
+            ProgramCache::store(pending.Key, pending.Program, compileMs);
+
+        Unique[pending.Content].reset(new Shader(pending.Program, pending.Desc.VertexPath,
+                                                 pending.Desc.FragmentPath, pending.Desc.Defines));
+    }
+
+    // Linked programs keep what they need; the stage objects can go
+    for (GLuint stage : Stages)
+        glDeleteShader(stage);
+    Stages.clear();
+
+    // 5. Publish names; a failed program leaves the name unresolved, as
+    // does a source that could not be read
+    int failed = (int)UnreadNames.size();
+    for (const auto& name : PendingNames)
+    {
+        auto program = Unique.find(name.second);
+        if (program == Unique.end())
+        {
+            ++failed;
+            continue;
+        }
+        Programs[name.first] = program->second.get();
+    }
+
+    // 6. Release programs no name resolves to any more (their names were
+    // resubmitted with new sources or defines); Shader frees through GLDeletions
+    std::set<const Shader*> referenced;
+    for (const auto& name : Programs)
+        referenced.insert(name.second);
+    for (auto unique = Unique.begin(); unique != Unique.end(); )
+    {
+        if (referenced.count(unique->second.get()))
+            ++unique;
+        else
+            unique = Unique.erase(unique);
+    }
+
+    Pending.clear();
+    PendingNames.clear();
+    UnreadNames.clear();
+    SubmitMs = 0.0;
+    return failed;
+}
+
+int ShaderLibrary::compile()
+{
+    submit();
+    return finish();
+}
+
+Shader* ShaderLibrary::get(const std::string& name) const
+{
+    auto found = Programs.find(name);
+    return found != Programs.end() ? found->second : nullptr;
+}
+
+void ShaderLibrary::printStats(std::ostream& out) const
+{
+    out << "Shader library: "
+        << Stats.Requested << " requested, "
+        << Stats.ProgramsLinked << " linked, "
+        << Stats.ProgramReuses << " shared; "
+        << Stats.StageCompiles << " stage compile(s), "
+        << Stats.StageReuses << " stage(s) shared" << std::endl;
+}
@@ -0,0 +1,348 @@
+//
+//  ShaderPreprocessor.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/10/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ShaderPreprocessor.h"
+#include "EmbeddedShaders.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Start of the directive name if [line, end) is a directive, else null
+    const char * DirectiveName(const char * line, const char * end)
+    {
+        const char * i = line;
+        while (i < end && (*i == ' ' || *i == '\t'))
+            ++i;
+        if (i == end || *i != '#')
+            return nullptr;
+
+        ++i;
+        while (i < end && (*i == ' ' || *i == '\t'))
+            ++i;
+        return i;
+    }
+
+    // True if the directive at name is the given one; rest is left just after it
+    bool IsDirective(const char * i, const char * end, const char * name, const char *& rest)
+    {
+        if (!i)
+            return false;
+
+        const size_t length = std::strlen(name);
+        if ((size_t)(end - i) < length || std::memcmp(i, name, length) != 0)
+            return false;
+
+        i += length;
+        if (i < end && *i != ' ' && *i != '\t' && *i != '\r')
+            return false;
+
+        rest = i;
+        return true;
+    }
+
+    // Comments and blank lines may precede #version
+    bool IsBlank(const char * line, const char * end)
+    {
+        while (line < end && (*line == ' ' || *line == '\t' || *line == '\r'))
+            ++line;
+        return line == end || (end - line >= 2 && line[0] == '/' && line[1] == '/');
+    }
+
+    std::string DefineLines(const std::vector<std::string>& defines)
+    {
+        std::string lines;
+        for (std::string define : defines)
+        {
+            std::replace(define.begin(), define.end(), '=', ' ');
+            lines += "#define " + define + "\n";
+        }
+        return lines;
+    }
+
+    std::string LineDirective(int number, size_t index)
+    {
+        return "#line " + std::to_string(number) + " " + std::to_string(index) + "\n";
+    }
+}
+
+uint64_t PreprocessedSource::hash(uint64_t seed) const
+{
+    uint64_t hash = seed;
+    for (size_t i = 0; i < Strings.size(); ++i)
+        hash = HashBytes(Strings[i], Lengths[i], hash);
+    return hash;
+}
+
+std::string PreprocessedSource::code() const
+{
+    std::string code;
+    for (size_t i = 0; i < Strings.size(); ++i)
+        code.append(Strings[i], Lengths[i]);
+    return code;
+}
+
+void PreprocessedSource::clear()
+{
+    Strings.clear();
+    Lengths.clear();
+    Files.clear();
+    Mappings.clear();
+    Generated.clear();
+    ReadMs       = 0.0;
+    PreprocessMs = 0.0;
+}
+
+void PreprocessedSource::append(const char * text, size_t length)
+{
+    if (length == 0)
+        return;
+    Strings.push_back(text);
+    Lengths.push_back((GLint)length);
+}
+
+void PreprocessedSource::append(std::string text)
+{
+    Generated.push_back(std::move(text));
+    append(Generated.back().data(), Generated.back().size());
+}
+
+bool ShaderPreprocessor::expand(const std::string& path,
+                                const std::vector<std::string>& defines,
+                                PreprocessedSource& result,
+                                SourceFiles files)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    result.clear();
+    result.Strings.reserve(8);
+    result.Lengths.reserve(8);
+
+    std::vector<std::string> stack;
+    const bool expanded = ExpandFile(path, defines, stack, files, result);
+
+    // ExpandFile accumulated ReadMs; the rest is the preprocessing proper
+    result.PreprocessMs = MillisecondsSince(start) - result.ReadMs;
+    return expanded;
+}
+
+std::string ShaderPreprocessor::joinDefines(const std::vector<std::string>& defines, char separator)
+{
+    // Order must not matter, or the same permutation would hash differently
+    std::vector<std::string> sorted(defines);
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string joined;
+    for (const std::string& define : sorted)
+    {
+        if (!joined.empty())
+            joined += separator;
+        joined += define;
+    }
+    return joined;
+}
+
+bool ShaderPreprocessor::ExpandFile(const std::string& path,
+                                    const std::vector<std::string>& defines,
+                                    std::vector<std::string>& stack,
+                                    SourceFiles files,
+                                    PreprocessedSource& result)
+{
+    if (std::find(stack.begin(), stack.end(), path) != stack.end())
+    {
+        std::cerr << "ERROR::SHADER::INCLUDE_CYCLE Path=" << path << std::endl;
+        return false;
+    }
+
+    // Include-once: shared code may be pulled in from several places
+    if (std::find(result.Files.begin(), result.Files.end(), path) != result.Files.end())
+        return true;
+
+    const char * source = nullptr;
+    const char * finish = nullptr;
+
+    // Embedded text is static; only loose files need mapping
+    if (EmbeddedShaders::isEmbedded(path))
+    {
+        const EmbeddedFile* embedded = EmbeddedShaders::find(path);
+        if (!embedded)
+        {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ Path=" << path << " (Not an embedded shader)" << std::endl;
+            return false;
+        }
+        source = embedded->Data;
+        finish = source + embedded->Size;
+    }
+    else if (files == SourceFiles::Copied)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::string text, error;
+        const bool read = ReadFile(path, text, error);
+        result.ReadMs += MillisecondsSince(start);
+
+        if (!read)
+        {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ Path=" << path << " (" << error << ")" << std::endl;
+            return false;
+        }
+        result.Generated.push_back(std::move(text));
+        source = result.Generated.back().data();
+        finish = source + result.Generated.back().size();
+    }
+    else
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::unique_ptr<MappedFile> file(new MappedFile(path));
+        result.ReadMs += MillisecondsSince(start);
+
+        if (!file->isOpen())
+        {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ Path=" << path << " (" << file->error() << ")" << std::endl;
+            return false;
+        }
+        source = file->data();
+        finish = source + file->size();
+        result.Mappings.push_back(std::move(file));
+    }
+
+    const bool   root  = stack.empty();
+    const size_t index = result.Files.size();
+    result.Files.push_back(path);
+    stack.push_back(path);
+
+    if (!root)
+        result.append(LineDirective(1, index));
+
+    bool injected = !root;
+    int  number   = 0;
+
+    // Untouched text accumulates in [run, line) and goes out as one span
+    const char * run = source;
+
+    for (const char * line = source; line < finish; )
+    {
+        const char * end  = static_cast<const char *>(std::memchr(line, '\n', finish - line));
+        const char * next = end ? end + 1 : finish;
+        if (!end)
+            end = finish;
+        ++number;
+
+        const char * rest = end;
+        const char * name = DirectiveName(line, end);
+
+        if (IsDirective(name, end, "version", rest))
+        {
+            // Only the root may declare a version; defines must follow it
+            if (root)
+            {
+                result.append(run, next - run);
+                if (!defines.empty())
+                {
+                    if (next == finish && end == finish)
+                        result.append("\n");
+                    result.append(DefineLines(defines) + LineDirective(number + 1, index));
+                }
+                injected = true;
+            }
+            else
+            {
+                result.append(run, line - run);
+            }
+            run  = next;
+            line = next;
+            continue;
+        }
+
+        if (!injected && !defines.empty() && !IsBlank(line, end))
+        {
+            result.append(run, line - run);
+            result.append(DefineLines(defines) + LineDirective(number, index));
+            run = line;
+            injected = true;
+        }
+
+        if (IsDirective(name, end, "include", rest))
+        {
+            const char * open = rest;
+            while (open < end && *open != '"' && *open != '<')
+                ++open;
+            const char * close = open < end ? open + 1 : end;
+            while (close < end && *close != '"' && *close != '>')
+                ++close;
+
+            if (close >= end)
+            {
+                std::cerr << "ERROR::SHADER::MALFORMED_INCLUDE Path=" << path << ":" << number << std::endl;
+                stack.pop_back();
+                return false;
+            }
+
+            result.append(run, line - run);
+
+            const std::string include(open + 1, close - open - 1);
+            if (!ExpandFile(EmbeddedShaders::normalize(DirectoryOf(path) + include), defines, stack, files, result))
+            {
+                stack.pop_back();
+                return false;
+            }
+
+            result.append(LineDirective(number + 1, index));
+            run  = next;
+            line = next;
+            continue;
+        }
+
+        line = next;
+    }
+
+    result.append(run, finish - run);
+
+    // Keep the following #line on its own line
+    if (finish > source && finish[-1] != '\n')
+        result.append("\n");
+
+    stack.pop_back();
+    return true;
+}
+
+std::string ShaderPreprocessor::DirectoryOf(const std::string& path)
+{
+    std::string::size_type slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+bool ShaderPreprocessor::ReadFile(const std::string& path, std::string& text, std::string& error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    if (file.bad())
+    {
+        error = "Read failed";
+        return false;
+    }
+    text = contents.str();
+    return true;
+}
@@ -0,0 +1,174 @@
+//
+//  ShaderProfiler.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/24/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ShaderProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    bool Enabled = true;
+    std::vector<ShaderTiming> Timings;
+
+    std::string JsonString(const std::string& text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '"':  quoted += "\\\""; break;
+                case '\\': quoted += "\\\\"; break;
+                case '\n': quoted += "\\n";  break;
+                case '\t': quoted += "\\t";  break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char escape[8];
+                        std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                        quoted += escape;
+                    }
+                    else
+                    {
+                        quoted += c;
+                    }
+            }
+        }
+        return quoted + "\"";
+    }
+
+    std::string Label(const ShaderTiming& timing)
+    {
+        std::string label = timing.FragmentPath;
+        if (!timing.Defines.empty())
+            label += " [" + timing.Defines + "]";
+        if (timing.Reload)
+            label += " (reload)";
+        return label;
+    }
+}
+
+void ShaderProfiler::setEnabled(bool enabled)
+{
+    Enabled = enabled;
+}
+
+bool ShaderProfiler::isEnabled()
+{
+    return Enabled;
+}
+
+void ShaderProfiler::record(const ShaderTiming& timing)
+{
+    if (Enabled)
+        Timings.push_back(timing);
+}
+
+const std::vector<ShaderTiming>& ShaderProfiler::timings()
+{
+    return Timings;
+}
+
+void ShaderProfiler::clear()
+{
+    Timings.clear();
+}
+
+void ShaderProfiler::printReport(std::ostream& out, size_t count)
+{
+    std::vector<const ShaderTiming*> sorted;
+    for (const ShaderTiming& timing : Timings)
+        sorted.push_back(&timing);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const ShaderTiming* a, const ShaderTiming* b) { return a->totalMs() > b->totalMs(); });
+
+    if (count == 0 || count > sorted.size())
+        count = sorted.size();
+
+    ShaderTiming sum;
+    size_t hits = 0;
+    for (const ShaderTiming& timing : Timings)
+    {
+        sum.ReadMs            += timing.ReadMs;
+        sum.PreprocessMs      += timing.PreprocessMs;
+        sum.CacheMs           += timing.CacheMs;
+        sum.VertexCompileMs   += timing.VertexCompileMs;
+        sum.FragmentCompileMs += timing.FragmentCompileMs;
+        sum.LinkMs            += timing.LinkMs;
+        hits += timing.CacheHit ? 1 : 0;
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%9s %7s %7s %7s %8s %8s %8s  %-5s  %s\n",
+                  "total ms", "read", "prep", "lookup", "vs", "fs", "link", "cache", "program");
+    out << "Shader build times (" << Timings.size() << " program(s), " << hits << " cache hit(s)):" << std::endl << line;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ShaderTiming& timing = *sorted[i];
+        std::snprintf(line, sizeof(line), "%9.2f %7.2f %7.2f %7.2f %8.2f %8.2f %8.2f%s  %-5s  ",
+                      timing.totalMs(), timing.ReadMs, timing.PreprocessMs, timing.CacheMs,
+                      timing.VertexCompileMs, timing.FragmentCompileMs, timing.LinkMs,
+                      timing.Batched ? "*" : " ", timing.CacheHit ? "hit" : "miss");
+        out << line << Label(timing) << (timing.Linked ? "" : " FAILED") << std::endl;
+    }
+
+    std::snprintf(line, sizeof(line), "%9.2f %7.2f %7.2f %7.2f %8.2f %8.2f %8.2f   ",
+                  sum.totalMs(), sum.ReadMs, sum.PreprocessMs, sum.CacheMs,
+                  sum.VertexCompileMs, sum.FragmentCompileMs, sum.LinkMs);
+    out << line << "       total" << std::endl;
+
+    for (const ShaderTiming& timing : Timings)
+    {
+        if (timing.Batched)
+        {
+            out << "  * batched: compile + link averaged over the batch" << std::endl;
+            break;
+        }
+    }
+}
+
+void ShaderProfiler::writeJson(std::ostream& out)
+{
+    out << "[\n";
+    for (size_t i = 0; i < Timings.size(); ++i)
+    {
+        const ShaderTiming& timing = Timings[i];
+        out << "  {"
+            << "\"vertex\": "            << JsonString(timing.VertexPath)
+            << ", \"fragment\": "        << JsonString(timing.FragmentPath)
+            << ", \"defines\": "         << JsonString(timing.Defines)
+            << ", \"read_ms\": "         << timing.ReadMs
+            << ", \"preprocess_ms\": "   << timing.PreprocessMs
+            << ", \"cache_ms\": "        << timing.CacheMs
+            << ", \"vertex_compile_ms\": "   << timing.VertexCompileMs
+            << ", \"fragment_compile_ms\": " << timing.FragmentCompileMs
+            << ", \"link_ms\": "         << timing.LinkMs
+            << ", \"total_ms\": "        << timing.totalMs()
+            << ", \"cache_hit\": "       << (timing.CacheHit ? "true" : "false")
+            << ", \"linked\": "          << (timing.Linked ? "true" : "false")
+            << ", \"reload\": "          << (timing.Reload ? "true" : "false")
+            << ", \"batched\": "         << (timing.Batched ? "true" : "false")
+            << "}" << (i + 1 < Timings.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+bool ShaderProfiler::writeJson(const std::string& path)
+{
+    std::ofstream file(path, std::ios::trunc);
+    writeJson(file);
+    if (!file)
+    {
+        std::cerr << "ERROR::SHADER_PROFILER::WRITE_FAILED Path=" << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,346 @@
+//
+//  ShaderWatcher.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/6/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <set>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace
+{
+    // Editors often write a file in several steps; wait for
+    // the burst to settle before reading it back.
+    const std::chrono::milliseconds SETTLE_DELAY(50);
+    const int                       WAKE_INTERVAL_MS = 100;
+}
+
+ShaderWatcher::ShaderWatcher()
+    : Running(false)
+{
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    stop();
+    for (auto& shader : Shaders)
+        shader.first->Watcher = nullptr;
+}
+
+void ShaderWatcher::watch(Shader& shader)
+{
+    PreprocessedSource vertex, fragment;
+    std::vector<std::string> files;
+    if (!shader.loadSources(vertex, fragment, &files))
+        files = { shader.vertexPath(), shader.fragmentPath() };
+    
+    if (shader.Watcher && shader.Watcher != this)
+        shader.Watcher->unwatch(shader);
+    shader.Watcher = this;
+
+    WatchedShader watched = { shader.vertexPath(), shader.fragmentPath(), shader.defines(), ResolvePaths(files) };
+
+    std::lock_guard<std::mutex> guard(Lock);
+    Shaders[&shader] = std::move(watched);
+}
+
+void ShaderWatcher::unwatch(Shader& shader)
+{
+    if (shader.Watcher == this)
+        shader.Watcher = nullptr;
+
+    std::lock_guard<std::mutex> guard(Lock);
+    Shaders.erase(&shader);
+    Pending.erase(std::remove_if(Pending.begin(), Pending.end(),
+                                 [&](const PendingReload& reload) { return reload.Target == &shader; }),
+                  Pending.end());
+}
+
+void ShaderWatcher::Moved(Shader& from, Shader& to)
+{
+    from.Watcher = nullptr;
+    to.Watcher   = this;
+
+    std::lock_guard<std::mutex> guard(Lock);
+    auto watched = Shaders.find(&from);
+    if (watched != Shaders.end())
+    {
+        Shaders[&to] = std::move(watched->second);
+        Shaders.erase(watched);
+    }
+
+    for (PendingReload& reload : Pending)
+        if (reload.Target == &from)
+            reload.Target = &to;
+}
+
+void ShaderWatcher::start()
+{
+    if (Running.exchange(true))
+        return;
+    Worker = std::thread(&ShaderWatcher::Run, this);
+}
+
+void ShaderWatcher::stop()
+{
+    Running = false;
+    if (Worker.joinable())
+        Worker.join();
+}
+
+int ShaderWatcher::poll()
+{
+    // Never stall the frame on the watcher; try again next frame
+    std::vector<PendingReload> ready;
+    {
+        std::unique_lock<std::mutex> guard(Lock, std::try_to_lock);
+        if (!guard.owns_lock() || Pending.empty())
+            return 0;
+        ready.swap(Pending);
+    }
+
+    int swapped = 0;
+    for (const PendingReload& reload : ready)
+    {
+        if (reload.Target->reload(reload.Vertex, reload.Fragment))
+        {
+            std::cout << "Reloaded shader " << reload.Target->fragmentPath() << std::endl;
+            ++swapped;
+        }
+    }
+    return swapped;
+}
+
+void ShaderWatcher::QueueReloads(const std::vector<std::string>& changedPaths)
+{
+    // Snapshot targets so file reads happen outside the lock
+    std::map<Shader*, WatchedShader> targets;
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        targets = Shaders;
+    }
+
+    std::vector<PendingReload> reloads;
+    std::vector<std::vector<std::string>> files;
+    for (const auto& target : targets)
+    {
+        const WatchedShader& watched = target.second;
+        bool changed = false;
+        for (const std::string& path : changedPaths)
+            changed = changed || std::find(watched.Dependencies.begin(), watched.Dependencies.end(), path) != watched.Dependencies.end();
+
+        if (!changed)
+            continue;
+
+        // Copied, not mapped: the file may be rewritten again before poll() compiles it
+        PendingReload reload;
+        reload.Target = target.first;
+        if (ShaderPreprocessor::expand(watched.VertexPath, watched.Defines, reload.Vertex, SourceFiles::Copied) &&
+            ShaderPreprocessor::expand(watched.FragmentPath, watched.Defines, reload.Fragment, SourceFiles::Copied))
+        {
+            files.emplace_back(reload.Vertex.Files);
+            files.back().insert(files.back().end(), reload.Fragment.Files.begin(), reload.Fragment.Files.end());
+            reloads.push_back(std::move(reload));
+        }
+        else
+        {
+            std::cerr << "ERROR::SHADER_WATCHER::FILE_NOT_SUCCESFULLY_READ Path=" << watched.FragmentPath << std::endl;
+        }
+    }
+
+    if (reloads.empty())
+        return;
+
+    std::lock_guard<std::mutex> guard(Lock);
+    for (size_t i = 0; i < reloads.size(); ++i)
+    {
+        PendingReload& reload = reloads[i];
+
+        // Drop reloads for shaders unwatched while we were reading. One
+        // moved meanwhile is dropped too, as its address is stale; the
+        // next save picks it up.
+        auto watched = Shaders.find(reload.Target);
+        if (watched == Shaders.end())
+            continue;
+
+        // An edit may have added or removed #includes
+        watched->second.Dependencies = ResolvePaths(files[i]);
+
+        // A newer read supersedes one the GL thread has not picked up yet
+        Pending.erase(std::remove_if(Pending.begin(), Pending.end(),
+                                     [&](const PendingReload& queued) { return queued.Target == reload.Target; }),
+                      Pending.end());
+        Pending.push_back(std::move(reload));
+    }
+}
+
+#ifdef __linux__
+
+void ShaderWatcher::Run()
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "ERROR::SHADER_WATCHER::INOTIFY_INIT_FAILED" << std::endl;
+        Running = false;
+        return;
+    }
+
+    // Watch directories rather than files: editors that save by
+    // rename would otherwise leave a watch on the deleted inode.
+    std::map<int, std::string> directories;
+    std::set<std::string>      watched;
+    const uint32_t             mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+    std::vector<char> buffer(16 * 1024);
+
+    while (Running)
+    {
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            for (const auto& shader : Shaders)
+            {
+                for (const std::string& path : shader.second.Dependencies)
+                {
+                    std::string directory = DirectoryOf(path);
+                    if (!watched.insert(directory).second)
+                        continue;
+
+                    int wd = inotify_add_watch(fd, directory.c_str(), mask);
+                    if (wd >= 0)
+                        directories[wd] = directory;
+                    else
+                        std::cerr << "ERROR::SHADER_WATCHER::WATCH_FAILED Path=" << directory << std::endl;
+                }
+            }
+        }
+
+        pollfd descriptor = { fd, POLLIN, 0 };
+        if (::poll(&descriptor, 1, WAKE_INTERVAL_MS) <= 0)
+            continue;
+
+        std::this_thread::sleep_for(SETTLE_DELAY);
+
+        std::vector<std::string> changed;
+        ssize_t length;
+        while ((length = ::read(fd, buffer.data(), buffer.size())) > 0)
+        {
+            for (char* cursor = buffer.data(); cursor < buffer.data() + length; )
+            {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(cursor);
+                if (event->len > 0 && directories.count(event->wd))
+                    changed.push_back(directories[event->wd] + "/" + event->name);
+                cursor += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        if (!changed.empty())
+            QueueReloads(changed);
+    }
+
+    ::close(fd);
+}
+
+#else
+
+void ShaderWatcher::Run()
+{
+    // No inotify: compare modification times on each wake-up
+    std::map<std::string, struct timespec> modified;
+
+    auto ModifiedTime = [](const std::string& path, struct timespec& time) {
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0)
+            return false;
+        #ifdef __APPLE__
+            time = info.st_mtimespec;
+        #else
+            time = info.st_mtim;
+        #endif
+        return true;
+    };
+
+    while (Running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAKE_INTERVAL_MS));
+
+        std::vector<std::string> paths;
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            for (const auto& shader : Shaders)
+                paths.insert(paths.end(), shader.second.Dependencies.begin(), shader.second.Dependencies.end());
+        }
+
+        std::vector<std::string> changed;
+        for (const std::string& path : paths)
+        {
+            struct timespec time;
+            if (!ModifiedTime(path, time))
+                continue;
+
+            auto known = modified.find(path);
+            if (known == modified.end())
+            {
+                modified[path] = time;
+            }
+            else if (known->second.tv_sec != time.tv_sec || known->second.tv_nsec != time.tv_nsec)
+            {
+                known->second = time;
+                changed.push_back(path);
+            }
+        }
+
+        if (!changed.empty())
+        {
+            std::this_thread::sleep_for(SETTLE_DELAY);
+            QueueReloads(changed);
+        }
+    }
+}
+
+#endif
+
+std::vector<std::string> ShaderWatcher::ResolvePaths(const std::vector<std::string>& paths)
+{
+    std::vector<std::string> resolved;
+    for (const std::string& path : paths)
+    {
+        // Embedded text can't change under us
+        if (!EmbeddedShaders::isEmbedded(path))
+            resolved.push_back(ResolvePath(path));
+    }
+    return resolved;
+}
+
+std::string ShaderWatcher::ResolvePath(const std::string& path)
+{
+    char resolved[PATH_MAX];
+    if (::realpath(path.c_str(), resolved))
+        return resolved;
+    return path;
+}
+
+std::string ShaderWatcher::DirectoryOf(const std::string& path)
+{
+    std::string::size_type slash = path.rfind('/');
+    if (slash == std::string::npos)
+        return ".";
+    if (slash == 0)
+        return "/";
+    return path.substr(0, slash);
+}
@@ -0,0 +1,161 @@
+//
+//  TextureArray.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/15/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "TextureArray.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+#include "PixelUpload.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+// TextureArrays
+/*---------------------------------*/
+const ArrayLayer * TextureArrays::find(const std::string& name) const
+{
+    auto found = Layers.find(name);
+    return found == Layers.end() ? nullptr : &found->second;
+}
+
+void TextureArrays::upload()
+{
+    // The pixels went with the first upload
+    if (isUploaded())
+    {
+        std::cerr << "ERROR::TEXTURE_ARRAY::ALREADY_UPLOADED" << std::endl;
+        return;
+    }
+
+    const int limit = maxLayers();
+    for (Group& group : Groups)
+    {
+        // Keeps group indices valid; binding it samples as incomplete
+        if (group.Layers > limit)
+        {
+            std::cerr << "ERROR::TEXTURE_ARRAY::TOO_MANY_LAYERS Layers=" << group.Layers << " Limit=" << limit << std::endl;
+            Textures.push_back(GLTexture());
+            std::vector<unsigned char>().swap(group.Pixels);
+            continue;
+        }
+
+        const PixelFormat format = PixelFormatFor(group.Channels);
+
+        GLTexture texture = GLTexture::create();
+        GLState.bindTexture(GL_TEXTURE_2D_ARRAY, texture.id());
+
+        // Rows of 1 to 3 channel images are not 4 byte aligned in general
+        glPixelStorei(GL_UNPACK_ALIGNMENT, UnpackAlignmentFor((size_t)group.Width * group.Channels,
+                                                              (uintptr_t)group.Pixels.data()));
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format.Internal, group.Width, group.Height, group.Layers, 0,
+                     format.Format, GL_UNSIGNED_BYTE, group.Pixels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        // Grey and grey + alpha sample as grey in every channel
+        if (group.Channels == 1 || group.Channels == 2)
+        {
+            const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, group.Channels == 2 ? GL_GREEN : GL_ONE };
+            glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        }
+
+        // Mips are per layer, nothing bleeds between images
+        if (Options.Mipmaps)
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, Options.Wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, Options.Wrap);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, Options.Mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Textures.push_back(std::move(texture));
+
+        std::vector<unsigned char>().swap(group.Pixels);
+    }
+}
+
+int TextureArrays::maxLayers()
+{
+    GLint layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &layers);
+    return layers;
+}
+
+void TextureArrays::bind(size_t group, GLuint unit) const
+{
+    GLState.bindTexture(unit, GL_TEXTURE_2D_ARRAY, Textures[group].id());
+}
+
+// TextureArrayBuilder
+/*---------------------------------*/
+TextureArrayBuilder::TextureArrayBuilder(const TextureArrayOptions& options)
+    : Options(options)
+{
+    Options.MaxLayers = std::max(1, Options.MaxLayers);
+}
+
+void TextureArrayBuilder::add(const std::string& name, const unsigned char * pixels, int width, int height, int channels)
+{
+    Image image;
+    image.Name     = name;
+    image.Width    = width;
+    image.Height   = height;
+    image.Channels = channels;
+    image.Pixels.assign(pixels, pixels + (size_t)width * height * channels);
+    Images.push_back(std::move(image));
+}
+
+bool TextureArrayBuilder::addFile(const std::string& path)
+{
+    ImageDecodeOptions options;
+    options.FlipVertically = true;
+    DecodedPixels pixels = ImageDecoder::decodeFile(path, options);
+    if (!pixels.isValid())
+    {
+        std::cerr << "ERROR::TEXTURE_ARRAY::LOAD_FAILED Path=" << path << " (" << pixels.error() << ")" << std::endl;
+        return false;
+    }
+
+    // Straight into the builder's copy: the flip is that copy
+    Image image;
+    image.Name     = path;
+    image.Width    = pixels.width();
+    image.Height   = pixels.height();
+    image.Channels = pixels.channels();
+    image.Pixels.resize(pixels.size());
+    pixels.writeRows(image.Pixels.data());
+    Images.push_back(std::move(image));
+    return true;
+}
+
+TextureArrays TextureArrayBuilder::build() const
+{
+    TextureArrays arrays;
+    arrays.Options = Options;
+
+    // Size and channel count -> the group still taking layers
+    std::map<std::tuple<int, int, int>, size_t> open;
+    for (const Image& image : Images)
+    {
+        const auto key = std::make_tuple(image.Width, image.Height, image.Channels);
+        auto found = open.find(key);
+        if (found == open.end() || arrays.Groups[found->second].Layers == Options.MaxLayers)
+        {
+            TextureArrays::Group group;
+            group.Width    = image.Width;
+            group.Height   = image.Height;
+            group.Channels = image.Channels;
+            arrays.Groups.push_back(std::move(group));
+            open[key] = arrays.Groups.size() - 1;
+            found = open.find(key);
+        }
+
+        TextureArrays::Group& group = arrays.Groups[found->second];
+        group.Pixels.insert(group.Pixels.end(), image.Pixels.begin(), image.Pixels.end());
+        arrays.Layers[image.Name] = ArrayLayer{ found->second, group.Layers++ };
+    }
+    return arrays;
+}
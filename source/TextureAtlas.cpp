@@ -0,0 +1,336 @@
+//
+//  TextureAtlas.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/13/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "TextureAtlas.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace
+{
+    int RoundUp(int value, int multiple)
+    {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // Skyline, bottom-left: the lowest place a rectangle's bottom can
+    // rest on, leftmost among equals
+    class Skyline
+    {
+    public:
+        explicit Skyline(int size) : Size(size), Segments(1, Segment{ 0, 0, size }) {}
+
+        bool insert(int width, int height, int& x, int& y)
+        {
+            size_t best = Segments.size();
+            int bestY = Size;
+            for (size_t i = 0; i < Segments.size(); ++i)
+            {
+                int top;
+                if (Fits(i, width, height, top) && top < bestY)
+                {
+                    best  = i;
+                    bestY = top;
+                }
+            }
+            if (best == Segments.size())
+                return false;
+
+            x = Segments[best].X;
+            y = bestY;
+            Place(best, width, height, bestY);
+            return true;
+        }
+
+        int height() const
+        {
+            int top = 0;
+            for (const Segment& segment : Segments)
+                top = std::max(top, segment.Y);
+            return top;
+        }
+
+    private:
+        struct Segment
+        {
+            int X, Y, Width;
+        };
+
+        int Size;
+        std::vector<Segment> Segments;
+
+        // A rectangle starting at segment i rests on the highest segment it spans
+        bool Fits(size_t index, int width, int height, int& y) const
+        {
+            const int x = Segments[index].X;
+            if (x + width > Size)
+                return false;
+
+            y = 0;
+            for (size_t i = index, covered = 0; covered < (size_t)width; ++i)
+            {
+                y = std::max(y, Segments[i].Y);
+                covered += Segments[i].Width;
+            }
+            return y + height <= Size;
+        }
+
+        void Place(size_t index, int width, int height, int y)
+        {
+            const int x = Segments[index].X;
+            Segments.insert(Segments.begin() + index, Segment{ x, y + height, width });
+
+            // Trim or drop what the new segment now covers
+            for (size_t i = index + 1; i < Segments.size(); )
+            {
+                Segment& segment = Segments[i];
+                const int end = x + width;
+                if (segment.X >= end)
+                    break;
+
+                const int overlap = std::min(end - segment.X, segment.Width);
+                segment.X     += overlap;
+                segment.Width -= overlap;
+                if (segment.Width == 0)
+                    Segments.erase(Segments.begin() + i);
+                else
+                    break;
+            }
+
+            // Merge neighbours at the same height
+            for (size_t i = 0; i + 1 < Segments.size(); )
+            {
+                if (Segments[i].Y == Segments[i + 1].Y)
+                {
+                    Segments[i].Width += Segments[i + 1].Width;
+                    Segments.erase(Segments.begin() + i + 1);
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+        }
+    };
+}
+
+// TextureAtlas
+/*---------------------------------*/
+const AtlasRegion * TextureAtlas::find(const std::string& name) const
+{
+    auto found = Regions.find(name);
+    return found == Regions.end() ? nullptr : &found->second;
+}
+
+double TextureAtlas::coverage(size_t page) const
+{
+    const MipImage& base = Pages[page][0];
+    return (double)CoveredTexels[page] / ((size_t)base.Width * base.Height);
+}
+
+void TextureAtlas::upload()
+{
+    Textures.clear();
+    for (const std::vector<MipImage>& levels : Pages)
+    {
+        GLTexture texture = GLTexture::create();
+        GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+        for (size_t level = 0; level < levels.size(); ++level)
+        {
+            const MipImage& image = levels[level];
+            glTexImage2D(GL_TEXTURE_2D, (GLint)level, GL_RGBA8, image.Width, image.Height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, image.Pixels.data());
+        }
+
+        // Past MaxLevel the gutters are less than a texel and images bleed
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        Textures.push_back(std::move(texture));
+    }
+}
+
+void TextureAtlas::bind(size_t page, GLuint unit) const
+{
+    GLState.bindTexture(unit, GL_TEXTURE_2D, Textures[page].id());
+}
+
+void TextureAtlas::rewriteUVs(float * vertices, size_t count, size_t strideFloats, size_t uvOffsetFloats,
+                              const AtlasRegion& region)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        float * uv = vertices + i * strideFloats + uvOffsetFloats;
+        const glm::vec2 mapped = region.map(glm::vec2(uv[0], uv[1]));
+        uv[0] = mapped.x;
+        uv[1] = mapped.y;
+    }
+}
+
+// TextureAtlasBuilder
+/*---------------------------------*/
+TextureAtlasBuilder::TextureAtlasBuilder(const AtlasOptions& options)
+    : Options(options), Levels(0)
+{
+    // The deepest level at which a gutter is still a whole texel
+    while ((2 << Levels) <= Options.Padding)
+        ++Levels;
+    Alignment = 1 << Levels;
+}
+
+bool TextureAtlasBuilder::add(const std::string& name, const unsigned char * pixels, int width, int height, int channels)
+{
+    const int padding = RoundUp(Options.Padding, Alignment);
+    if (RoundUp(width + 2 * padding, Alignment) > Options.PageSize || RoundUp(height + 2 * padding, Alignment) > Options.PageSize)
+    {
+        std::cerr << "ERROR::ATLAS::TOO_LARGE Name=" << name << " (" << width << "x" << height << ")" << std::endl;
+        return false;
+    }
+
+    Image image;
+    image.Name   = name;
+    image.Width  = width;
+    image.Height = height;
+    image.Pixels.resize((size_t)width * height * 4);
+
+    // Expand the way GL does for GL_RED, GL_RG and GL_RGB sources
+    const size_t texels = (size_t)width * height;
+    for (size_t i = 0; i < texels; ++i)
+    {
+        const unsigned char * in = pixels + i * channels;
+        unsigned char * out = &image.Pixels[i * 4];
+        out[0] = in[0];
+        out[1] = channels > 1 ? in[1] : 0;
+        out[2] = channels > 2 ? in[2] : 0;
+        out[3] = channels > 3 ? in[3] : 255;
+    }
+
+    Images.push_back(std::move(image));
+    return true;
+}
+
+bool TextureAtlasBuilder::addFile(const std::string& path)
+{
+    ImageDecodeOptions options;
+    options.FlipVertically = true;
+    DecodedPixels pixels = ImageDecoder::decodeFile(path, options);
+    if (!pixels.isValid())
+    {
+        std::cerr << "ERROR::ATLAS::LOAD_FAILED Path=" << path << " (" << pixels.error() << ")" << std::endl;
+        return false;
+    }
+    return add(path, pixels.data(), pixels.width(), pixels.height(), pixels.channels());
+}
+
+TextureAtlas TextureAtlasBuilder::build() const
+{
+    const int padding = RoundUp(Options.Padding, Alignment);
+
+    // Tallest first packs a skyline tightest
+    std::vector<size_t> order(Images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+    {
+        return Images[a].Height != Images[b].Height ? Images[a].Height > Images[b].Height
+                                                    : Images[a].Width > Images[b].Width;
+    });
+
+    struct Placement
+    {
+        size_t Image, Page;
+        int X, Y;       // slot corner, gutter included
+    };
+    std::vector<Placement> placements;
+    std::vector<Skyline> skylines;
+
+    for (size_t index : order)
+    {
+        const Image& image = Images[index];
+        const int width  = RoundUp(image.Width  + 2 * padding, Alignment);
+        const int height = RoundUp(image.Height + 2 * padding, Alignment);
+
+        Placement placement = { index, 0, 0, 0 };
+        for (; placement.Page < skylines.size(); ++placement.Page)
+        {
+            if (skylines[placement.Page].insert(width, height, placement.X, placement.Y))
+                break;
+        }
+        if (placement.Page == skylines.size())
+        {
+            skylines.emplace_back(Options.PageSize);
+            skylines.back().insert(width, height, placement.X, placement.Y);
+        }
+        placements.push_back(placement);
+    }
+
+    // Pages shrink to what they use
+    std::vector<int> widths(skylines.size(), Alignment), heights(skylines.size(), Alignment);
+    for (const Placement& placement : placements)
+    {
+        const Image& image = Images[placement.Image];
+        widths[placement.Page] = std::max(widths[placement.Page], placement.X + RoundUp(image.Width + 2 * padding, Alignment));
+    }
+    for (size_t page = 0; page < skylines.size(); ++page)
+        heights[page] = std::max(heights[page], skylines[page].height());
+
+    // Copy each image into its slot; the gutter repeats the nearest
+    // edge texel, so filtering across the border sees the same colour
+    std::vector<std::vector<unsigned char>> pixels(skylines.size());
+    for (size_t page = 0; page < skylines.size(); ++page)
+        pixels[page].assign((size_t)widths[page] * heights[page] * 4, 0);
+
+    TextureAtlas atlas;
+    atlas.CoveredTexels.assign(skylines.size(), 0);
+    for (const Placement& placement : placements)
+    {
+        const Image& image = Images[placement.Image];
+        const int pageWidth  = widths[placement.Page];
+        const int pageHeight = heights[placement.Page];
+        const int slotWidth  = RoundUp(image.Width  + 2 * padding, Alignment);
+        const int slotHeight = RoundUp(image.Height + 2 * padding, Alignment);
+
+        for (int y = 0; y < slotHeight; ++y)
+        {
+            const int sy = std::min(std::max(y - padding, 0), image.Height - 1);
+            unsigned char * out = &pixels[placement.Page][((size_t)(placement.Y + y) * pageWidth + placement.X) * 4];
+            for (int x = 0; x < slotWidth; ++x, out += 4)
+            {
+                const int sx = std::min(std::max(x - padding, 0), image.Width - 1);
+                std::copy_n(&image.Pixels[((size_t)sy * image.Width + sx) * 4], 4, out);
+            }
+        }
+
+        AtlasRegion region;
+        region.Page   = placement.Page;
+        region.X      = placement.X + padding;
+        region.Y      = placement.Y + padding;
+        region.Width  = image.Width;
+        region.Height = image.Height;
+        region.Offset = glm::vec2((float)region.X / pageWidth, (float)region.Y / pageHeight);
+        region.Scale  = glm::vec2((float)region.Width / pageWidth, (float)region.Height / pageHeight);
+        atlas.Regions[image.Name] = region;
+        atlas.CoveredTexels[placement.Page] += (size_t)image.Width * image.Height;
+    }
+
+    MipOptions mips;
+    mips.Srgb = Options.Srgb;
+    mips.Pool = Options.Pool;
+    for (size_t page = 0; page < skylines.size(); ++page)
+    {
+        std::vector<MipImage> chain = GenerateMipChain(pixels[page].data(), widths[page], heights[page], 4, mips);
+        chain.resize(std::min(chain.size(), (size_t)Levels + 1));
+        atlas.Pages.push_back(std::move(chain));
+    }
+    atlas.MaxLevel = Levels;
+    return atlas;
+}
@@ -0,0 +1,121 @@
+//
+//  TextureCache.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/29/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "TextureCache.h"
+
+#include <iomanip>
+
+TextureCache::TextureCache(TextureLoader& loader, size_t budgetBytes)
+    : Loader(loader), Budget(budgetBytes)
+{
+}
+
+std::string TextureCache::MakeKey(const std::string& path, const TextureParams& params)
+{
+    // Same image, different sampling: a separate texture object
+    return path + '|' + std::to_string(params.WrapS)
+                + ',' + std::to_string(params.WrapT)
+                + ',' + std::to_string(params.MinFilter)
+                + ',' + std::to_string(params.MagFilter)
+                + ',' + (params.Mipmaps ? 'm' : '-')
+                + (params.FlipVertically ? 'f' : '-')
+                + (params.ExpandRGB ? 'x' : '-')
+                + (params.Stream ? 's' : '-');
+}
+
+std::shared_ptr<Texture> TextureCache::acquire(const std::string& path, const TextureParams& params)
+{
+    const std::string key = MakeKey(path, params);
+
+    auto found = Entries.find(key);
+    if (found != Entries.end())
+    {
+        ++Stats.Hits;
+        Lru.splice(Lru.begin(), Lru, found->second);
+        return *found->second;
+    }
+
+    ++Stats.Misses;
+    Lru.push_front(Loader.load(path, params));
+    Entries.emplace(key, Lru.begin());
+    return Lru.front();
+}
+
+size_t TextureCache::update()
+{
+    const size_t finished = Loader.update();
+    Evict(Budget);
+    return finished;
+}
+
+void TextureCache::clear()
+{
+    Evict(0);
+}
+
+void TextureCache::Evict(size_t budget)
+{
+    size_t bytes = residentBytes();
+
+    // Oldest first; anything still held (the loader holds textures it
+    // is decoding too) stays
+    for (auto entry = Lru.end(); bytes > budget && entry != Lru.begin(); )
+    {
+        --entry;
+        const std::shared_ptr<Texture>& texture = *entry;
+        if (texture.use_count() > 1 || (!texture->isReady() && !texture->hasFailed()))
+            continue;
+
+        bytes -= texture->gpuBytes();
+        ++Stats.Evictions;
+        Stats.EvictedBytes += texture->gpuBytes();
+
+        // The GL texture goes on the deletion queue with the last handle
+        Entries.erase(MakeKey(texture->path(), texture->params()));
+        entry = Lru.erase(entry);
+    }
+}
+
+size_t TextureCache::residentBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& texture : Lru)
+        bytes += texture->gpuBytes();
+    return bytes;
+}
+
+std::vector<TextureCacheEntry> TextureCache::resident() const
+{
+    std::vector<TextureCacheEntry> entries;
+    entries.reserve(Lru.size());
+    for (const auto& texture : Lru)
+    {
+        TextureCacheEntry entry;
+        entry.Path       = texture->path();
+        entry.Bytes      = texture->gpuBytes();
+        entry.References = texture.use_count() - 1;
+        entry.Ready      = texture->isReady();
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+void TextureCache::printStats(std::ostream& out) const
+{
+    const double mb = 1.0 / (1 << 20);
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    out << "Texture cache: "
+        << Entries.size() << " resident, "
+        << std::fixed << std::setprecision(1) << residentBytes() * mb << " / " << Budget * mb << " MB, "
+        << Stats.Hits << " hit(s), " << Stats.Misses << " miss(es), "
+        << Stats.Evictions << " eviction(s) (" << Stats.EvictedBytes * mb << " MB)" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
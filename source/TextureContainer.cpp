@@ -0,0 +1,217 @@
+//
+//  TextureContainer.cpp
+//  Shaders
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "TextureContainer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    const size_t PAYLOAD_ALIGNMENT = 16;
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+TextureContainer::TextureContainer(const std::string& path)
+    : File(path)
+{
+    if (!File.isOpen())
+    {
+        Error = File.error();
+        return;
+    }
+
+    if (!Validate())
+    {
+        Header = nullptr;
+        Levels = nullptr;
+    }
+}
+
+bool TextureContainer::Validate()
+{
+    if (File.size() < sizeof(TextureContainerHeader))
+    {
+        Error = "Truncated header";
+        return false;
+    }
+
+    // mmap returns page aligned memory, so the casts are aligned too
+    Header = reinterpret_cast<const TextureContainerHeader *>(File.data());
+    if (Header->Magic != MAGIC || Header->Version != VERSION)
+    {
+        Error = "Not a version " + std::to_string(VERSION) + " texture container";
+        return false;
+    }
+    if (channels(format()) == 0)
+    {
+        Error = "Unknown format " + std::to_string(Header->Format);
+        return false;
+    }
+    if (Header->LevelCount == 0 || Header->LevelCount > 32)
+    {
+        Error = "Bad level count " + std::to_string(Header->LevelCount);
+        return false;
+    }
+
+    const size_t tableEnd = sizeof(TextureContainerHeader) + Header->LevelCount * sizeof(TextureContainerLevel);
+    if (File.size() < tableEnd)
+    {
+        Error = "Truncated level table";
+        return false;
+    }
+    Levels = reinterpret_cast<const TextureContainerLevel *>(File.data() + sizeof(TextureContainerHeader));
+
+    for (size_t i = 0; i < Header->LevelCount; ++i)
+    {
+        const TextureContainerLevel& level = Levels[i];
+        if (level.Size != levelSize(format(), (int)level.Width, (int)level.Height) || level.Offset < tableEnd || level.Offset > File.size()
+            || level.Size > File.size() - level.Offset)
+        {
+            Error = "Level " + std::to_string(i) + " is out of bounds";
+            return false;
+        }
+    }
+    return true;
+}
+
+TextureLevel TextureContainer::level(size_t index) const
+{
+    const TextureContainerLevel& entry = Levels[index];
+
+    TextureLevel level;
+    level.Width  = (int)entry.Width;
+    level.Height = (int)entry.Height;
+    level.Data   = reinterpret_cast<const unsigned char *>(File.data()) + entry.Offset;
+    level.Size   = (size_t)entry.Size;
+    return level;
+}
+
+bool TextureContainer::write(const std::string& path, TextureFormat format, bool flipped, uint64_t sourceHash,
+                             const std::vector<TextureLevel>& levels, std::string& error)
+{
+    if (levels.empty())
+    {
+        error = "No levels";
+        return false;
+    }
+
+    TextureContainerHeader header;
+    header.Magic      = MAGIC;
+    header.Version    = VERSION;
+    header.Format     = static_cast<uint32_t>(format);
+    header.Flags      = flipped ? FLIPPED : 0;
+    header.Width      = (uint32_t)levels[0].Width;
+    header.Height     = (uint32_t)levels[0].Height;
+    header.LevelCount = (uint32_t)levels.size();
+    header.Reserved   = 0;
+    header.SourceHash = sourceHash;
+
+    std::vector<TextureContainerLevel> table(levels.size());
+    size_t offset = sizeof(header) + table.size() * sizeof(TextureContainerLevel);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        offset = AlignUp(offset, PAYLOAD_ALIGNMENT);
+        table[i].Width  = (uint32_t)levels[i].Width;
+        table[i].Height = (uint32_t)levels[i].Height;
+        table[i].Offset = offset;
+        table[i].Size   = levels[i].Size;
+        offset += levels[i].Size;
+    }
+
+    // Write then rename: a cut-short write must never leave a file whose
+    // SourceHash says it is up to date
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(TextureContainerLevel));
+
+        const char padding[PAYLOAD_ALIGNMENT] = {};
+        size_t written = sizeof(header) + table.size() * sizeof(TextureContainerLevel);
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            out.write(padding, table[i].Offset - written);
+            out.write(reinterpret_cast<const char *>(levels[i].Data), levels[i].Size);
+            written = table[i].Offset + levels[i].Size;
+        }
+
+        out.close();
+        if (!out)
+        {
+            error = std::strerror(errno);
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        error = std::strerror(errno);
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t TextureContainer::readSourceHash(const std::string& path)
+{
+    TextureContainerHeader header;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        return 0;
+    if (header.Magic != MAGIC || header.Version != VERSION)
+        return 0;
+    return header.SourceHash;
+}
+
+bool TextureContainer::isContainerPath(const std::string& path)
+{
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".tex") == 0;
+}
+
+int TextureContainer::channels(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::R8:      return 1;
+        case TextureFormat::RG8:     return 2;
+        case TextureFormat::RGB8:    return 3;
+        case TextureFormat::RGBA8:   return 4;
+        case TextureFormat::BC1:     return 3;
+        case TextureFormat::BC3:     return 4;
+        case TextureFormat::RGB16F:  return 3;
+        case TextureFormat::RGBA16F: return 4;
+    }
+    return 0;
+}
+
+bool TextureContainer::isCompressed(TextureFormat format)
+{
+    return format == TextureFormat::BC1 || format == TextureFormat::BC3;
+}
+
+bool TextureContainer::isHalfFloat(TextureFormat format)
+{
+    return format == TextureFormat::RGB16F || format == TextureFormat::RGBA16F;
+}
+
+size_t TextureContainer::levelSize(TextureFormat format, int width, int height)
+{
+    if (!isCompressed(format))
+        return (size_t)width * height * channels(format) * (isHalfFloat(format) ? 2 : 1);
+
+    const size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == TextureFormat::BC1 ? 8 : 16);
+}
@@ -0,0 +1,529 @@
+//
+//  TextureLoader.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "TextureLoader.h"
+#include "BlockCompression.h"
+#include "GLExtensions.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "MipChain.h"
+#include "PixelUpload.h"
+#include "TextureContainer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // Levels this size and smaller go up with a streamed texture's first upload
+    const int STREAM_TAIL = 64;
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Compressed formats have no client format; HDR ones are half floats
+    PixelFormat FormatFor(TextureFormat format)
+    {
+        switch (format)
+        {
+            case TextureFormat::BC1:     return { GL_COMPRESSED_RGB_S3TC_DXT1_EXT,  0 };
+            case TextureFormat::BC3:     return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0 };
+            case TextureFormat::RGB16F:
+            case TextureFormat::RGBA16F: return HalfFormatFor(TextureContainer::channels(format));
+            default:                     return PixelFormatFor(TextureContainer::channels(format));
+        }
+    }
+
+    // Drivers store RGB8 and RGB16F padded out to four channels
+    size_t LevelBytes(TextureFormat format, int width, int height)
+    {
+        if (format == TextureFormat::RGB8)
+            return (size_t)width * height * 4;
+        if (format == TextureFormat::RGB16F)
+            return (size_t)width * height * 8;
+        return TextureContainer::levelSize(format, width, height);
+    }
+
+    // Including the chain glGenerateMipmap would add below the levels given
+    size_t EstimateBytes(TextureFormat format, const std::vector<TextureLevel>& levels, bool mipmaps)
+    {
+        size_t bytes = 0;
+        for (const TextureLevel& level : levels)
+            bytes += LevelBytes(format, level.Width, level.Height);
+
+        if (levels.size() == 1 && mipmaps)
+        {
+            for (int width = levels[0].Width, height = levels[0].Height; width > 1 || height > 1; )
+            {
+                width  = std::max(1, width / 2);
+                height = std::max(1, height / 2);
+                bytes += LevelBytes(format, width, height);
+            }
+        }
+        return bytes;
+    }
+}
+
+struct TextureLoader::DecodedImage
+{
+    std::shared_ptr<Texture> Target;                         // until uploaded,
+    std::weak_ptr<Texture> Streamed;                         // then, while streaming
+    DecodedPixels Pixels;                                    // a decoded image,
+    HalfPixels Halves;                                       // or an HDR one,
+    std::unique_ptr<TextureContainer> Baked;                 // or a mapped container
+    std::vector<std::vector<unsigned char>> Expanded;        // or blocks decoded here
+    std::vector<MipImage> Mips;                              // or a chain built to stream
+    std::vector<TextureLevel> Levels;                        // pointing into one of them
+    TextureFormat Format = TextureFormat::RGBA8;
+    size_t Base = 0;                                         // largest level uploaded
+    std::string Error;
+};
+
+TextureLoader::TextureLoader(size_t workers, size_t ringSize)
+    : Workers(workers), Ring(ringSize ? ringSize : 1)
+{
+    for (RingSlot& slot : Ring)
+        slot.Buffer = GLBuffer::create();
+
+    // Mid grey: neither loud nor mistaken for real content
+    const unsigned char grey[4] = { 128, 128, 128, 255 };
+    Placeholder = GLTexture::create();
+    GLState.bindTexture(GL_TEXTURE_2D, Placeholder.id());
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+TextureLoader::~TextureLoader()
+{
+    // Decode tasks use Lock and Decoded, which go before Workers would
+    Workers.wait();
+
+    for (RingSlot& slot : Ring)
+        if (slot.Fence)
+            glDeleteSync(slot.Fence);
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::string& path, const TextureParams& params)
+{
+    std::shared_ptr<Texture> texture(new Texture(path, params, Placeholder.id()));
+    ++Stats.Requested;
+
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        ++InFlight;
+    }
+    Workers.submit([this, texture] { Decode(texture); });
+    return texture;
+}
+
+void TextureLoader::Decode(std::shared_ptr<Texture> texture)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::unique_ptr<DecodedImage> image(new DecodedImage());
+    image->Target = texture;
+
+    if (TextureContainer::isContainerPath(texture->path()))
+        Map(*image);
+    else
+        DecodeImage(*image);
+
+    const double decodeMs = MillisecondsSince(start);
+
+    std::lock_guard<std::mutex> guard(Lock);
+    Decoded.push_back(std::move(image));
+    DecodeMs += decodeMs;
+}
+
+void TextureLoader::DecodeImage(DecodedImage& image)
+{
+    // The flip is per call, so workers with different params don't race.
+    // It happens as the rows are copied into the upload buffer.
+    ImageDecodeOptions options;
+    options.FlipVertically = image.Target->params().FlipVertically;
+    options.ExpandRGB      = image.Target->params().ExpandRGB;
+
+    MappedFile file(image.Target->path());
+    if (!file.isOpen())
+    {
+        image.Error = file.error();
+        return;
+    }
+
+    // HDR goes up as half floats, converted here with the rows shared
+    // among the idle workers; the upload copies them as they are. RGB
+    // stays RGB16F: widening it would undo the memory halves save.
+    if (ImageDecoder::isHdr(file.data(), file.size()))
+    {
+        options.ExpandRGB = false;
+        image.Halves = ImageDecoder::decodeHalf(file.data(), file.size(), options, &Workers);
+        if (!image.Halves.isValid())
+        {
+            image.Error = image.Halves.Error;
+            return;
+        }
+
+        image.Format = image.Halves.Channels == 4 ? TextureFormat::RGBA16F : TextureFormat::RGB16F;
+
+        TextureLevel level;
+        level.Width  = image.Halves.Width;
+        level.Height = image.Halves.Height;
+        level.Data   = reinterpret_cast<const unsigned char *>(image.Halves.Data.data());
+        level.Size   = image.Halves.size();
+        image.Levels.push_back(level);
+        return;
+    }
+
+    image.Pixels = ImageDecoder::decode(file.data(), file.size(), options);
+    if (!image.Pixels.isValid())
+    {
+        image.Error = image.Pixels.error();
+        return;
+    }
+
+    // Channel counts are the uncompressed format values
+    image.Format = static_cast<TextureFormat>(image.Pixels.channels());
+
+    // Streaming needs every level before the first upload, so the chain
+    // is built here rather than by glGenerateMipmap
+    const TextureParams& params = image.Target->params();
+    if (params.Stream && params.Mipmaps)
+    {
+        MipOptions mips;
+        mips.Pool = &Workers;
+        image.Mips = GenerateMipChain(image.Pixels.data(), image.Pixels.width(), image.Pixels.height(),
+                                      image.Pixels.channels(), mips);
+        image.Pixels = DecodedPixels();
+        for (const MipImage& mip : image.Mips)
+            image.Levels.push_back(mip.level());
+        return;
+    }
+
+    TextureLevel level;
+    level.Width  = image.Pixels.width();
+    level.Height = image.Pixels.height();
+    level.Size   = image.Pixels.size();
+    image.Levels.push_back(level);
+}
+
+void TextureLoader::Map(DecodedImage& image)
+{
+    // Baked levels are uploaded as they are; the flip happened at bake time
+    image.Baked.reset(new TextureContainer(image.Target->path()));
+    if (!image.Baked->isOpen())
+    {
+        image.Error = image.Baked->error();
+        return;
+    }
+
+    const size_t count = image.Target->params().Mipmaps ? image.Baked->levelCount() : 1;
+    for (size_t i = 0; i < count; ++i)
+        image.Levels.push_back(image.Baked->level(i));
+    image.Format = image.Baked->format();
+
+    // Without S3TC the driver can't take the blocks; decode them here,
+    // off the GL thread, rather than fail
+    if (TextureContainer::isCompressed(image.Format) && !GLExt.HasTextureCompressionS3TC)
+    {
+        for (TextureLevel& level : image.Levels)
+        {
+            image.Expanded.push_back(DecompressBlocks(image.Format, level.Data, level.Width, level.Height));
+            level.Data = image.Expanded.back().data();
+            level.Size = image.Expanded.back().size();
+        }
+        image.Format = TextureFormat::RGBA8;
+    }
+
+    if (image.Format == TextureFormat::RGB8 && image.Target->params().ExpandRGB)
+    {
+        for (TextureLevel& level : image.Levels)
+        {
+            const size_t texels = (size_t)level.Width * level.Height;
+            image.Expanded.emplace_back(texels * 4);
+            ExpandRGBToRGBA(level.Data, image.Expanded.back().data(), texels);
+            level.Data = image.Expanded.back().data();
+            level.Size = image.Expanded.back().size();
+        }
+        image.Format = TextureFormat::RGBA8;
+    }
+}
+
+size_t TextureLoader::update()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t finished = 0;
+
+    for (size_t uploads = 0; uploads < Ring.size(); )
+    {
+        RingSlot * slot = FreeSlot();
+        if (!slot)
+            break;
+
+        std::unique_ptr<DecodedImage> image;
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            if (Decoded.empty())
+                break;
+            image = std::move(Decoded.front());
+            Decoded.pop_front();
+            --InFlight;
+            Stats.DecodeMs = DecodeMs;
+        }
+
+        ++finished;
+        if (image->Levels.empty())
+        {
+            std::cerr << "ERROR::TEXTURE::LOAD_FAILED Path=" << image->Target->path() << " (" << image->Error << ")" << std::endl;
+            image->Target->Failed = true;
+            ++Stats.Failed;
+            continue;
+        }
+
+        Upload(std::move(image), *slot);
+        ++uploads;
+    }
+
+    const size_t streamed = Stream();
+
+    if (finished || streamed)
+        Stats.UploadMs += MillisecondsSince(start);
+    return finished;
+}
+
+TextureLoader::RingSlot * TextureLoader::FreeSlot()
+{
+    RingSlot& slot = Ring[NextSlot];
+    if (slot.Fence)
+    {
+        // Still being read by the GPU: try again next frame
+        if (glClientWaitSync(slot.Fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return nullptr;
+        glDeleteSync(slot.Fence);
+        slot.Fence = 0;
+    }
+    return &slot;
+}
+
+void TextureLoader::Upload(std::unique_ptr<DecodedImage> image, RingSlot& slot)
+{
+    Texture& texture = *image->Target;
+    const TextureParams& params = texture.params();
+    const size_t count = image->Levels.size();
+    const int channels = TextureContainer::channels(image->Format);
+
+    // Streaming starts with the small end of the chain
+    size_t first = 0;
+    if (params.Stream)
+    {
+        while (first + 1 < count && std::max(image->Levels[first].Width, image->Levels[first].Height) > STREAM_TAIL)
+            ++first;
+    }
+
+    texture.Object = GLTexture::create();
+    GLState.bindTexture(GL_TEXTURE_2D, texture.Object.id());
+    const size_t size = UploadLevels(*image, first, count, slot);
+
+    // Grey and grey + alpha sample as grey in every channel
+    if (channels == 1 || channels == 2)
+    {
+        const GLint swizzle[4] = { GL_RED, GL_RED, GL_RED, channels == 2 ? GL_GREEN : GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.WrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.WrapT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.MinFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.MagFilter);
+
+    // Baked (or streamed) textures bring their own chain. The levels
+    // above the base are left undefined until they stream in.
+    if (count > 1)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)first);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)count - 1);
+    }
+    else if (params.Mipmaps)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    const TextureLevel& base = image->Levels[0];
+    texture.Width     = base.Width;
+    texture.Height    = base.Height;
+    texture.Channels  = channels;
+    texture.BaseLevel = (int)first;
+    texture.Bytes     = EstimateBytes(image->Format, image->Levels, params.Mipmaps);
+    texture.Ready     = true;
+
+    ++Stats.Uploaded;
+    Stats.BytesUploaded += size;
+
+    // Streaming doesn't keep the texture alive: once nothing else holds
+    // it (TextureCache may evict it) the rest of its chain is dropped
+    if (first > 0)
+    {
+        image->Base     = first;
+        image->Streamed = image->Target;
+        image->Target.reset();
+        Streaming.push_back(std::move(image));
+    }
+}
+
+size_t TextureLoader::UploadLevels(DecodedImage& image, size_t first, size_t end, RingSlot& slot)
+{
+    size_t size = 0;
+    for (size_t i = first; i < end; ++i)
+        size += image.Levels[i].Size;
+
+    // Fill the slot's buffer. Its fence has signalled, so nothing can
+    // still be reading it and the map need not synchronise.
+    GLState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer.id());
+    if (slot.Capacity < size)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        slot.Capacity = size;
+    }
+
+    unsigned char * mapped = static_cast<unsigned char *>(
+        glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (mapped)
+    {
+        size_t offset = 0;
+        for (size_t i = first; i < end; ++i)
+        {
+            const TextureLevel& level = image.Levels[i];
+            if (image.Pixels.isValid())
+                image.Pixels.writeRows(mapped + offset);
+            else
+                std::memcpy(mapped + offset, level.Data, level.Size);
+            offset += level.Size;
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        // Fall back to a client-memory upload
+        GLState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (image.Pixels.isValid())
+            image.Levels[0].Data = image.Pixels.data();
+    }
+
+    // The copy into the texture happens on the GPU timeline from here
+    const PixelFormat format = FormatFor(image.Format);
+    const size_t texelBytes = TextureContainer::levelSize(image.Format, 1, 1);
+    const bool compressed = TextureContainer::isCompressed(image.Format);
+
+    size_t offset = 0;
+    for (size_t i = first; i < end; ++i)
+    {
+        const TextureLevel& level = image.Levels[i];
+        const void * source = mapped ? (const void *)offset : level.Data;
+
+        // Rows of 1 to 3 channel levels are not 4 byte aligned in general
+        if (!compressed)
+            glPixelStorei(GL_UNPACK_ALIGNMENT, UnpackAlignmentFor((size_t)level.Width * texelBytes, (uintptr_t)source));
+
+        if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, format.Internal, level.Width, level.Height, 0,
+                                   (GLsizei)level.Size, source);
+        else
+            glTexImage2D(GL_TEXTURE_2D, (GLint)i, format.Internal, level.Width, level.Height, 0,
+                         format.Format, format.Type, source);
+        offset += level.Size;
+    }
+
+    if (!compressed)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    NextSlot = (NextSlot + 1) % Ring.size();
+
+    // Leaving it bound would turn every later glTexImage2D pointer into an offset
+    GLState.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return size;
+}
+
+size_t TextureLoader::Stream()
+{
+    // Released (or evicted): no one will ever see the detail
+    Streaming.erase(std::remove_if(Streaming.begin(), Streaming.end(),
+                                   [](const std::unique_ptr<DecodedImage>& image) { return image->Streamed.expired(); }),
+                    Streaming.end());
+
+    // Screen pixels per resident texel; the most starved goes next
+    auto priority = [](const std::unique_ptr<DecodedImage>& image)
+    {
+        const TextureLevel& level = image->Levels[image->Base];
+        return image->Streamed.lock()->screenSize() / (float)std::max(level.Width, level.Height);
+    };
+
+    size_t levels = 0;
+    size_t spent  = 0;
+    while (!Streaming.empty())
+    {
+        auto next = std::max_element(Streaming.begin(), Streaming.end(),
+                                     [&](const std::unique_ptr<DecodedImage>& a, const std::unique_ptr<DecodedImage>& b)
+                                     { return priority(a) < priority(b); });
+        DecodedImage& image = **next;
+        const size_t level = image.Base - 1;
+        const size_t bytes = image.Levels[level].Size;
+        if (spent > 0 && spent + bytes > StreamBudget)
+            break;
+
+        RingSlot * slot = FreeSlot();
+        if (!slot)
+            break;
+
+        const std::shared_ptr<Texture> target = image.Streamed.lock();
+        Texture& texture = *target;
+        GLState.bindTexture(GL_TEXTURE_2D, texture.Object.id());
+        UploadLevels(image, level, level + 1, *slot);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level);
+        image.Base = level;
+        texture.BaseLevel = (int)level;
+
+        // A chain built here is done with once its level is up
+        if (!image.Mips.empty())
+            std::vector<unsigned char>().swap(image.Mips[level].Pixels);
+
+        spent += bytes;
+        ++levels;
+        ++Stats.LevelsStreamed;
+        Stats.BytesStreamed += bytes;
+
+        if (level == 0)
+            Streaming.erase(next);
+    }
+    return levels;
+}
+
+void TextureLoader::finish()
+{
+    while (pending() > 0 || !Streaming.empty())
+    {
+        // Nothing to do until a decode lands or a fence signals; the
+        // flush makes sure queued fences actually reach the GPU
+        if (update() == 0)
+        {
+            glFlush();
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t TextureLoader::pending() const
+{
+    std::lock_guard<std::mutex> guard(Lock);
+    return InFlight;
+}
@@ -0,0 +1,129 @@
+//
+//  ThreadPool.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+        threads = hardwareThreads();
+
+    for (size_t i = 0; i < threads; ++i)
+        Workers.emplace_back(&ThreadPool::Run, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Stopping = true;
+    }
+    Wake.notify_all();
+
+    for (std::thread& worker : Workers)
+        worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(Lock);
+        Tasks.push_back(std::move(task));
+    }
+    Wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> guard(Lock);
+    Idle.wait(guard, [this] { return Tasks.empty() && Running == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& body)
+{
+    if (count == 0)
+        return;
+
+    // A few ranges per thread evens out uneven work
+    const size_t threads = Workers.size() + 1;
+    const size_t ranges  = std::min(count, threads * 4);
+    const size_t step    = (count + ranges - 1) / ranges;
+
+    // Shared so a helper that only starts after we return finds no work
+    // left and touches nothing on this stack
+    struct State
+    {
+        std::atomic<size_t>     Next;
+        std::atomic<size_t>     Done;
+        std::mutex              Lock;
+        std::condition_variable Finished;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->Next = 0;
+    state->Done = 0;
+
+    const std::function<void(size_t, size_t)>* work = &body;
+    auto drain = [state, work, ranges, step, count]
+    {
+        for (size_t range = state->Next++; range < ranges; range = state->Next++)
+        {
+            const size_t begin = range * step;
+            if (begin < count)
+                (*work)(begin, std::min(count, begin + step));
+
+            if (++state->Done == ranges)
+            {
+                std::lock_guard<std::mutex> guard(state->Lock);
+                state->Finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 0; i < Workers.size() && i + 1 < ranges; ++i)
+        submit(drain);
+    drain();
+
+    std::unique_lock<std::mutex> guard(state->Lock);
+    state->Finished.wait(guard, [&] { return state->Done == ranges; });
+}
+
+size_t ThreadPool::hardwareThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::Run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(Lock);
+            Wake.wait(guard, [this] { return Stopping || !Tasks.empty(); });
+            if (Tasks.empty())
+                return;
+
+            task = std::move(Tasks.front());
+            Tasks.pop_front();
+            ++Running;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> guard(Lock);
+            --Running;
+            if (Tasks.empty() && Running == 0)
+                Idle.notify_all();
+        }
+    }
+}
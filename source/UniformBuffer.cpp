@@ -0,0 +1,47 @@
+//
+//  UniformBuffer.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/12/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "UniformBuffer.h"
+
+#include <map>
+#include <vector>
+
+namespace
+{
+    std::map<std::string, GLuint>& Bindings()
+    {
+        static std::map<std::string, GLuint> bindings;
+        return bindings;
+    }
+}
+
+void UniformBlockBindings::set(const std::string& blockName, GLuint binding)
+{
+    Bindings()[blockName] = binding;
+}
+
+void UniformBlockBindings::apply(GLuint program)
+{
+    if (!program || Bindings().empty())
+        return;
+
+    GLint blocks = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blocks);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+
+    std::vector<GLchar> name(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < blocks; ++i)
+    {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)name.size(), &length, name.data());
+
+        auto binding = Bindings().find(std::string(name.data(), length));
+        if (binding != Bindings().end())
+            glUniformBlockBinding(program, (GLuint)i, binding->second);
+    }
+}
@@ -0,0 +1,136 @@
+//
+//  UniformTable.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+
+#include "UniformTable.h"
+
+#include <iostream>
+
+void UniformTable::build(GLuint program)
+{
+    clear();
+
+    GLint active = 0, maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &active);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    if (active <= 0)
+        return;
+
+    // Collect names first so the table can be sized once.
+    // Arrays report "name[0]"; every element is added by name
+    // along with the bare "name" alias for element 0.
+    std::vector<std::pair<std::string, GLint>> uniforms;
+    std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+
+    for (GLint i = 0; i < active; ++i)
+    {
+        GLsizei length = 0;
+        GLint   size   = 0;
+        GLenum  type   = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+        std::string name(buffer.data(), length);
+        GLint location = glGetUniformLocation(program, name.c_str());
+
+        // Uniforms inside a block have no location
+        if (location == -1)
+            continue;
+
+        uniforms.emplace_back(name, location);
+
+        std::string::size_type bracket = name.rfind("[0]");
+        if (bracket != std::string::npos && bracket + 3 == name.size())
+        {
+            std::string base = name.substr(0, bracket);
+            uniforms.emplace_back(base, location);
+
+            for (GLint element = 1; element < size; ++element)
+            {
+                std::string elementName = base + "[" + std::to_string(element) + "]";
+                uniforms.emplace_back(elementName, glGetUniformLocation(program, elementName.c_str()));
+            }
+        }
+    }
+
+    // Keep the load factor at or below 0.5
+    size_t capacity = 16;
+    while (capacity < uniforms.size() * 2)
+        capacity <<= 1;
+    Slots.resize(capacity);
+
+    for (const auto& uniform : uniforms)
+        Insert(uniform.first, uniform.second);
+}
+
+void UniformTable::clear()
+{
+    Slots.clear();
+    Count = 0;
+}
+
+UniformHandle UniformTable::find(const std::string& name) const
+{
+    UniformHandle handle;
+    if (Slots.empty())
+        return handle;
+
+    const uint32_t hash = HashUniformName(name.c_str());
+    const size_t   mask = Slots.size() - 1;
+
+    for (size_t i = hash & mask; !Slots[i].Name.empty(); i = (i + 1) & mask)
+    {
+        if (Slots[i].Hash == hash && Slots[i].Name == name)
+        {
+            handle.Location = Slots[i].Location;
+            break;
+        }
+    }
+    return handle;
+}
+
+UniformHandle UniformTable::find(uint32_t hash) const
+{
+    UniformHandle handle;
+    if (Slots.empty())
+        return handle;
+
+    const size_t mask = Slots.size() - 1;
+
+    for (size_t i = hash & mask; !Slots[i].Name.empty(); i = (i + 1) & mask)
+    {
+        if (Slots[i].Hash == hash)
+        {
+            handle.Location = Slots[i].Location;
+            break;
+        }
+    }
+    return handle;
+}
+
+void UniformTable::Insert(const std::string& name, GLint location)
+{
+    const uint32_t hash = HashUniformName(name.c_str());
+    const size_t   mask = Slots.size() - 1;
+
+    size_t i = hash & mask;
+    for (; !Slots[i].Name.empty(); i = (i + 1) & mask)
+    {
+        if (Slots[i].Hash == hash)
+        {
+            // Lookups by hash alone would be ambiguous
+            if (Slots[i].Name != name)
+                std::cerr << "WARNING::UNIFORM_TABLE::HASH_COLLISION " << Slots[i].Name << " / " << name << std::endl;
+            else
+                return;
+        }
+    }
+
+    Slots[i].Hash     = hash;
+    Slots[i].Location = location;
+    Slots[i].Name     = name;
+    ++Count;
+}
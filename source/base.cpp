@@ -10,6 +10,14 @@
 #include <cmath>
 
 #include "Shader.h"
+#include "EmbeddedShaders.h"
+#include "GLExtensions.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "ProgramCache.h"
+#include "ShaderProfiler.h"
+#include "ShaderWatcher.h"
+#include "VertexLayout.h"
 #include <glad/3.3/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -24,11 +32,20 @@ bool check_program_link(unsigned int program);
 // Global Variables
 /*---------------------------------*/
 char errlog[512];
-float vertices[] = {
-    // positions         // colors
-     0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,   // bottom right
-    -0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,   // bottom left
-     0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f    // top
+struct ColourVertex
+{
+    glm::vec3 Position;
+    glm::vec3 Colour;
+};
+using ColourVertexFormat = VertexLayout<ColourVertex,
+    VERTEX_ATTRIBUTE(ColourVertex, Position, 0),
+    VERTEX_ATTRIBUTE(ColourVertex, Colour,   1)>;
+
+ColourVertex vertices[] = {
+    // positions                // colors
+    { {  0.5f, -0.5f, 0.0f },  { 1.0f, 0.0f, 0.0f } },   // bottom right
+    { { -0.5f, -0.5f, 0.0f },  { 0.0f, 1.0f, 0.0f } },   // bottom left
+    { {  0.0f,  0.5f, 0.0f },  { 0.0f, 0.0f, 1.0f } }    // top
 };
 unsigned int indices[] = {  // note that we start from 0!
     0, 1, 3,   // first triangle
@@ -96,40 +113,38 @@ int main(int argc, const char * argv[])
         if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
             throw new std::runtime_error("[glad] Failed to initialize");
         
+        // Load optional entry points & enable program binary cache
+        /*---------------------------------*/
+        LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+        ProgramCache::enable(".shader_cache");
+        
         // Create Shader Object
         /*---------------------------------*/
         
         
         // Create & Bind New Vertex Buffer Object(s)
         /*---------------------------------*/
-        unsigned int VBO, VAO, EBO;
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-        glGenVertexArrays(1, &VAO);
+        // (released through GLDeletions when they go out of scope)
+        GLBuffer      VBO = GLBuffer::create();
+        GLBuffer      EBO = GLBuffer::create();
+        GLVertexArray VAO = GLVertexArray::create();
         
         // Bind Buffer Array
         /*---------------------------------*/
-        glBindVertexArray(VAO);
+        GLState.bindVertexArray(VAO.id());
         
         // Bind & Set Vertex Buffer(s)
         /*---------------------------------*/
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        // (strides, offsets and types come from ColourVertex)
+        GLState.bindBuffer(GL_ARRAY_BUFFER, VBO.id());
+        ColourVertexFormat::upload(vertices, 3, VertexStreams::Interleaved);
         
-//        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+//        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO.id());
 //        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
         
-        // Configure Vertex Attributes
-        /*---------------------------------*/
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-        
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-        
         // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex
         // attribute's bound vertex buffer object so afterwards we can safely unbind
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        GLState.bindBuffer(GL_ARRAY_BUFFER, 0);
 
         // remember: do NOT unbind the EBO while a VAO is active as the bound element buffer object IS stored
         // in the VAO; keep the EBO bound.
@@ -138,12 +153,27 @@ int main(int argc, const char * argv[])
         // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this
         // rarely happens. Modifying other VAOs requires a call to glBindVertexArray anyways so we generally
         // don't unbind VAOs (nor VBOs) when it's not directly necessary.
-        glBindVertexArray(0);
+        GLState.bindVertexArray(0);
         
         // uncomment this call to draw in wireframe polygons.
         // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         
-        Shader myShader("base.vert", "base.frag");
+        // Release builds use the shaders compiled into the binary; debug
+        // builds read shaders/ so edits hot-reload
+        #ifdef DEBUG
+            EmbeddedShaders::loadFromDisk("shaders");
+        #endif
+        
+        Shader myShader(ShaderResource::vertex_base_vs, ShaderResource::fragment_base_fs);
+        ProgramCache::printStats(std::cout);
+        ShaderProfiler::printReport(std::cout);
+        ShaderProfiler::writeJson("shader_timings.json");
+        
+        // Watch shader files for hot-reload
+        /*---------------------------------*/
+        ShaderWatcher watcher;
+        watcher.watch(myShader);
+        watcher.start();
         
         // Run Loop
         /*---------------------------------*/
@@ -152,13 +182,19 @@ int main(int argc, const char * argv[])
             // Capture Input
             processInput(window);
             
+            // Start this frame's state change counters
+            GLState.beginFrame();
+            
+            // Swap in any edited shaders that linked
+            watcher.poll();
+            
             // Clear Screen
             glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
             
+            // Redundant binds are filtered by the state cache
             myShader.use();
-            
-            glBindVertexArray(VAO);
+            GLState.bindVertexArray(VAO.id());
             glDrawArrays(GL_TRIANGLES, 0, 3);
             
             // glfw: swap buffers and poll IO events
@@ -166,16 +202,24 @@ int main(int argc, const char * argv[])
             /*---------------------------------*/
             glfwSwapBuffers(window);
             glfwPollEvents();
+            
+            // Objects released this frame (e.g. reloaded programs)
+            GLDeletions.flush();
         }
         
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
+        std::cout << "GL state calls last frame: "
+                  << GLState.previous().Issued << " issued, "
+                  << GLState.previous().Filtered << " filtered" << std::endl;
     }
     catch (std::exception e)
     {
         std::cerr << "Exception Thrown! " << e.what() << std::endl;
     }
     
+    // Delete what the scope above released while the context still exists
+    /*---------------------------------*/
+    GLDeletions.flush();
+    
     // Terminate GLFW
     /*---------------------------------*/
     glfwTerminate();
@@ -196,7 +240,7 @@ void processInput(GLFWwindow *window)
 /*----------------------------------------------------*/
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    GLState.viewport(0, 0, width, height);
 }
 
 bool check_shader_compilation(unsigned int shader)
@@ -0,0 +1,243 @@
+//
+//  array_drawing.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/15/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Draws many quads, each with a material that blends two images, with
+//  fragment/blend.texture2.fs (two units bound per draw) and with
+//  fragment/blend.texture2.array.fs over TextureArrays: one bind and a
+//  uLayers uniform per draw, or one draw per array with the layers
+//  in a vertex attribute. Reports frame time and the GL state calls
+//  that got through the cache.
+//
+//      array_drawing [materials] [quads] [frames]
+//
+
+#include "bench.h"
+#include "EmbeddedShaders.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "TextureArray.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Vertex layout of vertex/base.vs, and the layer stream only the
+// LAYER_ATTRIBUTE permutation of vertex/base.array.vs reads
+struct QuadVertex
+{
+    glm::vec3 Position;
+    glm::vec3 Colour;
+    glm::vec2 UV;
+};
+using QuadVertexFormat = VertexLayout<QuadVertex,
+    VERTEX_ATTRIBUTE(QuadVertex, Position, 0),
+    VERTEX_ATTRIBUTE(QuadVertex, Colour,   1),
+    VERTEX_ATTRIBUTE(QuadVertex, UV,       2)>;
+
+struct LayerVertex
+{
+    glm::ivec2 Layers;
+};
+using LayerVertexFormat = VertexLayout<LayerVertex, VERTEX_ATTRIBUTE(LayerVertex, Layers, 3)>;
+
+const int IMAGE_SIZE = 64;
+
+// Stripes in a colour per image, so layers are told apart
+static std::vector<unsigned char> MakeImage(int index)
+{
+    std::vector<unsigned char> pixels((size_t)IMAGE_SIZE * IMAGE_SIZE * 4);
+    for (int y = 0; y < IMAGE_SIZE; ++y)
+    {
+        for (int x = 0; x < IMAGE_SIZE; ++x)
+        {
+            const bool stripe = ((x + y) / 8) % 2 == 0;
+            unsigned char * texel = &pixels[((size_t)y * IMAGE_SIZE + x) * 4];
+            texel[0] = stripe ? (unsigned char)(index * 53) : 0;
+            texel[1] = stripe ? (unsigned char)(index * 97) : 0;
+            texel[2] = stripe ? (unsigned char)(index * 151) : 0;
+            texel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+int main(int argc, const char * argv[])
+{
+    const int materialCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+    const int quadCount     = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2048;
+    const int frames        = argc > 3 ? std::max(1, std::atoi(argv[3])) : 50;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        // Two images per material: separate textures, and one array
+        /*---------------------------------*/
+        std::vector<GLTexture> textures;
+        TextureArrayBuilder builder;
+        for (int i = 0; i < materialCount * 2; ++i)
+        {
+            const std::vector<unsigned char> pixels = MakeImage(i);
+
+            GLTexture texture = GLTexture::create();
+            GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, IMAGE_SIZE, IMAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            textures.push_back(std::move(texture));
+
+            builder.add(std::to_string(i), pixels.data(), IMAGE_SIZE, IMAGE_SIZE, 4);
+        }
+
+        TextureArrays arrays = builder.build();
+        arrays.upload();
+        std::printf("%d images -> %zu array(s) of up to %d layers\n",
+                    materialCount * 2, arrays.groupCount(), arrays.layerCount(0));
+
+        std::vector<glm::ivec2> materialLayers(materialCount);
+        std::vector<size_t> materialGroups(materialCount);
+        for (int i = 0; i < materialCount; ++i)
+        {
+            const ArrayLayer * first  = arrays.find(std::to_string(i * 2));
+            const ArrayLayer * second = arrays.find(std::to_string(i * 2 + 1));
+            if (first->Group != second->Group)
+                throw std::runtime_error("Material " + std::to_string(i) + " spans two arrays");
+            materialLayers[i] = glm::ivec2(first->Layer, second->Layer);
+            materialGroups[i] = first->Group;
+        }
+
+        // Quads on a grid, material i % materialCount
+        /*---------------------------------*/
+        const int columns = (int)std::ceil(std::sqrt((double)quadCount));
+        const float size = 2.0f / columns;
+        std::vector<QuadVertex> vertices;
+        std::vector<LayerVertex> vertexLayers;
+        for (int i = 0; i < quadCount; ++i)
+        {
+            const float x = -1.0f + (i % columns) * size, y = -1.0f + (i / columns) * size;
+            const float corners[6][4] =
+            {
+                { x, y, 0, 0 }, { x + size, y, 1, 0 }, { x + size, y + size, 1, 1 },
+                { x, y, 0, 0 }, { x + size, y + size, 1, 1 }, { x, y + size, 0, 1 },
+            };
+            for (const auto& corner : corners)
+            {
+                vertices.push_back({ { corner[0], corner[1], 0.0f }, { 1.0f, 1.0f, 1.0f }, { corner[2], corner[3] } });
+                vertexLayers.push_back({ materialLayers[i % materialCount] });
+            }
+        }
+
+        GLBuffer vbo = GLBuffer::create(), layerVbo = GLBuffer::create();
+        GLVertexArray vao = GLVertexArray::create();
+        GLState.bindVertexArray(vao.id());
+        GLState.bindBuffer(GL_ARRAY_BUFFER, vbo.id());
+        QuadVertexFormat::upload(vertices.data(), vertices.size(), VertexStreams::Interleaved);
+
+        // Only read by the LAYER_ATTRIBUTE permutation
+        GLState.bindBuffer(GL_ARRAY_BUFFER, layerVbo.id());
+        LayerVertexFormat::upload(vertexLayers.data(), vertexLayers.size(), VertexStreams::Interleaved);
+
+        Shader separate(ShaderResource::vertex_base_vs, ShaderResource::fragment_blend_texture2_fs);
+        separate.use();
+        separate.setInt("uTexture1", 0);
+        separate.setInt("uTexture2", 1);
+
+        Shader layered(ShaderResource::vertex_base_array_vs, ShaderResource::fragment_blend_texture2_array_fs);
+        layered.use();
+        layered.setInt("uTextures", 0);
+        const UniformHandle layers = layered.getUniform("uLayers");
+
+        Shader attributed(ShaderResource::vertex_base_array_vs, ShaderResource::fragment_blend_texture2_array_fs,
+                          { "LAYER_ATTRIBUTE" });
+        attributed.use();
+        attributed.setInt("uTextures", 0);
+
+        // Frames
+        /*---------------------------------*/
+        enum class Mode { Separate, LayerUniform, LayerAttribute };
+        auto run = [&](Mode mode, unsigned int& calls)
+        {
+            GLState.beginFrame();
+            const double ns = bench::NanosecondsPerIteration(frames, [&](int)
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                GLState.bindVertexArray(vao.id());
+
+                // One draw per run of quads whose materials share an array
+                if (mode == Mode::LayerAttribute)
+                {
+                    attributed.use();
+                    for (int i = 0; i < quadCount; )
+                    {
+                        const size_t group = materialGroups[i % materialCount];
+                        int end = i + 1;
+                        while (end < quadCount && materialGroups[end % materialCount] == group)
+                            ++end;
+                        arrays.bind(group, 0);
+                        glDrawArrays(GL_TRIANGLES, i * 6, (end - i) * 6);
+                        i = end;
+                    }
+                    return;
+                }
+
+                Shader& shader = mode == Mode::Separate ? separate : layered;
+                shader.use();
+                for (int i = 0; i < quadCount; ++i)
+                {
+                    const int material = i % materialCount;
+                    if (mode == Mode::Separate)
+                    {
+                        GLState.bindTexture(0, GL_TEXTURE_2D, textures[material * 2].id());
+                        GLState.bindTexture(1, GL_TEXTURE_2D, textures[material * 2 + 1].id());
+                    }
+                    else
+                    {
+                        arrays.bind(materialGroups[material], 0);
+                        shader.setArray(layers, &materialLayers[material], 1);
+                    }
+                    glDrawArrays(GL_TRIANGLES, i * 6, 6);
+                }
+            });
+            GLState.beginFrame();
+            calls = GLState.previous().Issued / frames;
+            return ns / 1e3;
+        };
+
+        int runs = 1;
+        for (int i = 1; i < quadCount; ++i)
+            runs += materialGroups[i % materialCount] != materialGroups[(i - 1) % materialCount];
+
+        unsigned int separateCalls, uniformCalls, attributeCalls;
+        run(Mode::Separate, separateCalls);    // warm up
+        const double separateUs  = run(Mode::Separate, separateCalls);
+        const double uniformUs   = run(Mode::LayerUniform, uniformCalls);
+        const double attributeUs = run(Mode::LayerAttribute, attributeCalls);
+
+        std::printf("%d quads, %d materials, %d frames\n", quadCount, materialCount, frames);
+        std::printf("%-28s %12s %16s %8s\n", "path", "us / frame", "state calls", "draws");
+        std::printf("%-28s %12.1f %16u %8d\n", "two textures per draw", separateUs, separateCalls, quadCount);
+        std::printf("%-28s %12.1f %16u %8d\n", "array, uLayers per draw", uniformUs, uniformCalls, quadCount);
+        std::printf("%-28s %12.1f %16u %8d\n", "array, layer attribute", attributeUs, attributeCalls, runs);
+
+        textures.clear();
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
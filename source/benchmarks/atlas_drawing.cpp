@@ -0,0 +1,208 @@
+//
+//  atlas_drawing.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/13/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Draws many quads, each with one of many small images, the way the
+//  textured quad path does today (bind, draw, per quad) and from a
+//  TextureAtlas (UVs rewritten, one bind, per quad draws or a single
+//  draw). Reports frame time and the GL state calls that got through
+//  the cache.
+//
+//      atlas_drawing [images] [quads] [frames]
+//
+
+#include "bench.h"
+#include "EmbeddedShaders.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "TextureAtlas.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Vertex layout of vertex/base.vs
+struct QuadVertex
+{
+    glm::vec3 Position;
+    glm::vec3 Colour;
+    glm::vec2 UV;
+};
+using QuadVertexFormat = VertexLayout<QuadVertex,
+    VERTEX_ATTRIBUTE(QuadVertex, Position, 0),
+    VERTEX_ATTRIBUTE(QuadVertex, Colour,   1),
+    VERTEX_ATTRIBUTE(QuadVertex, UV,       2)>;
+
+const size_t VERTEX_FLOATS = sizeof(QuadVertex) / sizeof(float);
+const size_t UV_OFFSET     = offsetof(QuadVertex, UV) / sizeof(float);
+
+// A flat colour with a darker border, so bleeding would show
+static std::vector<unsigned char> MakeImage(int index, int width, int height)
+{
+    std::vector<unsigned char> pixels((size_t)width * height * 4);
+    const unsigned char r = (unsigned char)(index * 53), g = (unsigned char)(index * 97), b = (unsigned char)(index * 151);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const bool border = x == 0 || y == 0 || x == width - 1 || y == height - 1;
+            unsigned char * texel = &pixels[((size_t)y * width + x) * 4];
+            texel[0] = border ? r / 2 : r;
+            texel[1] = border ? g / 2 : g;
+            texel[2] = border ? b / 2 : b;
+            texel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+int main(int argc, const char * argv[])
+{
+    const int imageCount = argc > 1 ? std::max(1, std::atoi(argv[1])) : 64;
+    const int quadCount  = argc > 2 ? std::max(1, std::atoi(argv[2])) : 2048;
+    const int frames     = argc > 3 ? std::max(1, std::atoi(argv[3])) : 50;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        // Images: separate textures, and one atlas
+        /*---------------------------------*/
+        std::vector<GLTexture> textures;
+        TextureAtlasBuilder builder;
+        for (int i = 0; i < imageCount; ++i)
+        {
+            const int width = 16 << (i % 4), height = 16 << ((i / 4) % 4);
+            const std::vector<unsigned char> pixels = MakeImage(i, width, height);
+
+            GLTexture texture = GLTexture::create();
+            GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+            glGenerateMipmap(GL_TEXTURE_2D);
+            textures.push_back(std::move(texture));
+
+            builder.add(std::to_string(i), pixels.data(), width, height, 4);
+        }
+
+        bench::Clock::time_point start = bench::Clock::now();
+        TextureAtlas atlas = builder.build();
+        const double buildMs = bench::MillisecondsSince(start);
+        atlas.upload();
+
+        std::printf("%d images -> %zu atlas page(s), built in %.1f ms, levels 0-%d\n",
+                    imageCount, atlas.pageCount(), buildMs, atlas.maxLevel());
+        for (size_t page = 0; page < atlas.pageCount(); ++page)
+            std::printf("  page %zu: %dx%d, %.0f%% covered\n", page, atlas.page(page)[0].Width,
+                        atlas.page(page)[0].Height, atlas.coverage(page) * 100.0);
+
+        // Quads on a grid, in image order
+        /*---------------------------------*/
+        const int columns = (int)std::ceil(std::sqrt((double)quadCount));
+        const float size = 2.0f / columns;
+        std::vector<QuadVertex> vertices;
+        for (int i = 0; i < quadCount; ++i)
+        {
+            const float x = -1.0f + (i % columns) * size, y = -1.0f + (i / columns) * size;
+            const float corners[6][4] =
+            {
+                { x, y, 0, 0 }, { x + size, y, 1, 0 }, { x + size, y + size, 1, 1 },
+                { x, y, 0, 0 }, { x + size, y + size, 1, 1 }, { x, y + size, 0, 1 },
+            };
+            for (const auto& corner : corners)
+                vertices.push_back({ { corner[0], corner[1], 0.0f }, { 1.0f, 1.0f, 1.0f }, { corner[2], corner[3] } });
+        }
+
+        std::vector<QuadVertex> atlasVertices = vertices;
+        std::vector<size_t> quadPages(quadCount);
+        for (int i = 0; i < quadCount; ++i)
+        {
+            const AtlasRegion * region = atlas.find(std::to_string(i % imageCount));
+            TextureAtlas::rewriteUVs(&atlasVertices[(size_t)i * 6].Position.x, 6, VERTEX_FLOATS, UV_OFFSET, *region);
+            quadPages[i] = region->Page;
+        }
+        const bool onePage = atlas.pageCount() == 1;
+
+        auto makeMesh = [](const std::vector<QuadVertex>& data, GLBuffer& vbo, GLVertexArray& vao)
+        {
+            vbo = GLBuffer::create();
+            vao = GLVertexArray::create();
+            GLState.bindVertexArray(vao.id());
+            GLState.bindBuffer(GL_ARRAY_BUFFER, vbo.id());
+            QuadVertexFormat::upload(data.data(), data.size(), VertexStreams::Interleaved);
+        };
+        GLBuffer vbo, atlasVbo;
+        GLVertexArray vao, atlasVao;
+        makeMesh(vertices, vbo, vao);
+        makeMesh(atlasVertices, atlasVbo, atlasVao);
+
+        Shader shader(ShaderResource::vertex_base_vs, ShaderResource::fragment_texture_fs);
+        shader.use();
+        shader.setInt("uTexture1", 0);
+
+        // Frames
+        /*---------------------------------*/
+        enum class Mode { Separate, AtlasPerQuad, AtlasSingle };
+        auto run = [&](Mode mode, unsigned int& calls)
+        {
+            GLState.beginFrame();
+            const double ns = bench::NanosecondsPerIteration(frames, [&](int)
+            {
+                glClear(GL_COLOR_BUFFER_BIT);
+                shader.use();
+                GLState.bindVertexArray(mode == Mode::Separate ? vao.id() : atlasVao.id());
+
+                if (mode == Mode::AtlasSingle && onePage)
+                {
+                    atlas.bind(0, 0);
+                    glDrawArrays(GL_TRIANGLES, 0, quadCount * 6);
+                    return;
+                }
+
+                for (int i = 0; i < quadCount; ++i)
+                {
+                    if (mode == Mode::Separate)
+                        GLState.bindTexture(0, GL_TEXTURE_2D, textures[i % imageCount].id());
+                    else
+                        atlas.bind(quadPages[i], 0);
+                    glDrawArrays(GL_TRIANGLES, i * 6, 6);
+                }
+            });
+            GLState.beginFrame();
+            calls = GLState.previous().Issued / frames;
+            return ns / 1e3;
+        };
+
+        unsigned int separateCalls, perQuadCalls, singleCalls;
+        run(Mode::Separate, separateCalls);    // warm up
+        const double separateUs = run(Mode::Separate, separateCalls);
+        const double perQuadUs  = run(Mode::AtlasPerQuad, perQuadCalls);
+        const double singleUs   = run(Mode::AtlasSingle, singleCalls);
+
+        std::printf("%d quads, %d frames\n", quadCount, frames);
+        std::printf("%-28s %12s %16s %8s\n", "path", "us / frame", "state calls", "draws");
+        std::printf("%-28s %12.1f %16u %8d\n", "texture per image", separateUs, separateCalls, quadCount);
+        std::printf("%-28s %12.1f %16u %8d\n", "atlas, draw per quad", perQuadUs, perQuadCalls, quadCount);
+        std::printf("%-28s %12.1f %16u %8d\n", "atlas, one draw", singleUs, singleCalls, onePage ? 1 : quadCount);
+
+        textures.clear();
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,140 @@
+//
+//  batch_compile.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 6/8/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  50 programs built one at a time through the Shader constructor
+//  versus one ShaderLibrary batch. Every run writes unique sources so
+//  neither path benefits from the driver's own shader cache.
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLExtensions.h"
+#include "ShaderLibrary.h"
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+const int PROGRAM_COUNT = 50;
+
+// Writes a vertex/fragment pair that differs by a constant per index
+// and by the tag, so "seq3" and "batch3" are different programs too
+static ProgramDesc WriteVariant(const std::string& tag, int index)
+{
+    ProgramDesc desc;
+    desc.Name         = tag + std::to_string(index);
+    desc.VertexPath   = "bench_" + desc.Name + ".vs";
+    desc.FragmentPath = "bench_" + desc.Name + ".fs";
+
+    const std::string stamp    = std::to_string(std::time(NULL) % 100000);
+    const std::string constant = std::to_string(index) + ".0 / " + stamp + ".0";
+    const std::string varying  = "TexCoord_" + tag;
+    const std::string header   = "// " + desc.Name + " " + stamp + "\n";
+
+    std::string vertex =
+        "#version 330 core\n" + header +
+        "layout (location = 0) in vec3 Vertex;\n"
+        "layout (location = 2) in vec2 TextureVec;\n"
+        "out vec2 " + varying + ";\n"
+        "void main()\n"
+        "{\n"
+        "   gl_Position = vec4(Vertex * " + constant + ", 1.0);\n"
+        "   " + varying + " = TextureVec;\n"
+        "}\n";
+
+    std::string fragment =
+        "#version 330 core\n" + header +
+        "layout(location = 0) out vec4 Color;\n"
+        "in vec2 " + varying + ";\n"
+        "uniform sampler2D uTexture1;\n"
+        "uniform sampler2D uTexture2;\n"
+        "uniform float uBlend;\n"
+        "void main()\n"
+        "{\n"
+        "   vec4 sum = vec4(0.0);\n"
+        "   for (int i = 0; i < 8; ++i)\n"
+        "       sum += mix(texture(uTexture1, " + varying + " * float(i)), texture(uTexture2, " + varying + "), uBlend);\n"
+        "   Color = sum * " + constant + ";\n"
+        "}\n";
+
+    for (const auto& file : { std::make_pair(desc.VertexPath, vertex), std::make_pair(desc.FragmentPath, fragment) })
+    {
+        if (FILE *out = ::fopen(file.first.c_str(), "w"))
+        {
+            fputs(file.second.c_str(), out);
+            fclose(out);
+        }
+    }
+    return desc;
+}
+
+static void RemoveVariants(const std::vector<ProgramDesc>& descs)
+{
+    for (const ProgramDesc& desc : descs)
+    {
+        std::remove(desc.VertexPath.c_str());
+        std::remove(desc.FragmentPath.c_str());
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+        LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+        std::cout << "GL_KHR_parallel_shader_compile: " << (GLExt.HasParallelShaderCompile ? "yes" : "no") << std::endl;
+
+        std::vector<ProgramDesc> sequentialDescs, batchDescs;
+        for (int i = 0; i < PROGRAM_COUNT; ++i)
+        {
+            sequentialDescs.push_back(WriteVariant("seq", i));
+            batchDescs.push_back(WriteVariant("batch", i));
+        }
+
+        // Sequential: each constructor blocks on its own compile & link
+        bench::Clock::time_point start = bench::Clock::now();
+        std::vector<std::unique_ptr<Shader>> shaders;
+        for (const ProgramDesc& desc : sequentialDescs)
+            shaders.emplace_back(new Shader(desc.VertexPath.c_str(), desc.FragmentPath.c_str()));
+        glFinish();
+        double sequentialMs = bench::MillisecondsSince(start);
+
+        // Batched: issue everything, then wait once
+        ShaderLibrary library;
+        library.add(batchDescs);
+
+        start = bench::Clock::now();
+        library.submit();
+        double submitMs = bench::MillisecondsSince(start);
+        int failed = library.finish();
+        glFinish();
+        double batchMs = bench::MillisecondsSince(start);
+
+        std::printf("%-24s %10s\n", "path", "ms");
+        std::printf("%-24s %10.2f\n", "sequential Shader()", sequentialMs);
+        std::printf("%-24s %10.2f\n", "ShaderLibrary submit", submitMs);
+        std::printf("%-24s %10.2f\n", "ShaderLibrary total", batchMs);
+        std::printf("speedup %.2fx, %d failed\n", sequentialMs / batchMs, failed);
+
+        shaders.clear();
+        GLDeletions.flush();
+
+        RemoveVariants(sequentialDescs);
+        RemoveVariants(batchDescs);
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,77 @@
+//
+//  bench.h
+//  Benchmarks
+//
+//  Created by Crunchy on 6/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Shared helpers for the benchmark programs. The context is an
+//  invisible GLFW window, so on Linux run under a virtual display
+//  with Mesa's software rasterizer:
+//
+//      LIBGL_ALWAYS_SOFTWARE=1 xvfb-run ./uniform_setters
+//
+
+#ifndef bench_h
+#define bench_h
+
+#include <glad/3.3/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Creates a hidden 3.3 core context and loads glad
+    /*---------------------------------*/
+    inline GLFWwindow* CreateHeadlessContext()
+    {
+        if (!glfwInit())
+            throw std::runtime_error("[glfw] Failed to initialize");
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        #ifdef __APPLE__
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        #endif
+
+        GLFWwindow* window = glfwCreateWindow(64, 64, "bench", NULL, NULL);
+        if (!window)
+            throw std::runtime_error("[glfw] Unable to create window");
+
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+            throw std::runtime_error("[glad] Failed to initialize");
+
+        std::cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << std::endl;
+        return window;
+    }
+
+    inline double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Runs body() iterations times and returns nanoseconds per iteration.
+    // glFinish brackets the loop so queued driver work is included.
+    template <typename Body>
+    double NanosecondsPerIteration(int iterations, Body body)
+    {
+        glFinish();
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+            body(i);
+        glFinish();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    }
+}
+
+#endif
@@ -0,0 +1,229 @@
+//
+//  hdr_upload.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/22/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  HDR environment maps from Radiance data to the GPU. A procedural
+//  sky (a sun far brighter than 1, and a dim ground) is encoded as
+//  RGBE in memory, then:
+//
+//    - stbi_loadf alone;
+//    - float to half conversion, glm::packHalf1x16 a value at a time
+//      against FloatToHalf, checked to agree;
+//    - ImageDecoder::decodeHalf on one thread and on a pool;
+//    - uploading GL_RGB32F from floats against GL_RGB16F and
+//      GL_RGBA16F from halves, with the bytes each sends.
+//
+//      hdr_upload [width] [iterations]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+#include "PixelUpload.h"
+#include "ThreadPool.h"
+
+#include "stb_image.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Flat (not run length encoded) RGBE, which stbi reads as well
+static std::vector<unsigned char> EncodeRadiance(const std::vector<float>& rgb, int width, int height)
+{
+    const std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) +
+                               " +X " + std::to_string(width) + "\n";
+    std::vector<unsigned char> file(header.begin(), header.end());
+    file.reserve(file.size() + (size_t)width * height * 4);
+
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        const float * texel = &rgb[i * 3];
+        const float largest = std::max(texel[0], std::max(texel[1], texel[2]));
+        if (largest < 1e-32f)
+        {
+            file.insert(file.end(), { 0, 0, 0, 0 });
+            continue;
+        }
+
+        int exponent;
+        const float scale = std::frexp(largest, &exponent) * 256.0f / largest;
+        file.push_back((unsigned char)(texel[0] * scale));
+        file.push_back((unsigned char)(texel[1] * scale));
+        file.push_back((unsigned char)(texel[2] * scale));
+        file.push_back((unsigned char)(exponent + 128));
+    }
+    return file;
+}
+
+// Equirectangular: a gradient sky, a small sun of about 5000, dark ground
+static std::vector<float> MakeSky(int width, int height)
+{
+    const glm::vec3 sun = glm::normalize(glm::vec3(0.3f, 0.6f, 0.5f));
+    std::vector<float> rgb((size_t)width * height * 3);
+    for (int y = 0; y < height; ++y)
+    {
+        const float theta = (y + 0.5f) / height * 3.14159265f;
+        for (int x = 0; x < width; ++x)
+        {
+            const float phi = (x + 0.5f) / width * 6.28318531f;
+            const glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+            glm::vec3 colour = direction.y > 0.0f
+                             ? glm::mix(glm::vec3(0.9f, 1.0f, 1.2f), glm::vec3(0.2f, 0.4f, 1.0f), direction.y)
+                             : glm::vec3(0.05f, 0.04f, 0.03f);
+            const float facing = glm::dot(direction, sun);
+            if (facing > 0.9995f)
+                colour += glm::vec3(5000.0f, 4600.0f, 4000.0f);
+            else
+                colour += glm::vec3(2.0f, 1.8f, 1.5f) * std::pow(std::max(facing, 0.0f), 64.0f);
+
+            float * texel = &rgb[((size_t)y * width + x) * 3];
+            texel[0] = colour.r;
+            texel[1] = colour.g;
+            texel[2] = colour.b;
+        }
+    }
+    return rgb;
+}
+
+int main(int argc, const char * argv[])
+{
+    const int width      = argc > 1 ? std::max(8, std::atoi(argv[1])) : 2048;
+    const int height     = width / 2;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        const std::vector<unsigned char> file = EncodeRadiance(MakeSky(width, height), width, height);
+        const double megapixels = (double)width * height / 1e6;
+        std::printf("%dx%d Radiance, %.1f MB\n", width, height, file.size() / 1e6);
+        std::printf("  %-36s %10s %10s\n", "", "ms", "MP/s");
+
+        // Decode
+        /*---------------------------------*/
+        int w, h, channels;
+        stbi_set_flip_vertically_on_load_thread(0);
+        std::unique_ptr<float, void (*)(void *)> floats(
+            stbi_loadf_from_memory(file.data(), (int)file.size(), &w, &h, &channels, 3), stbi_image_free);
+        if (!floats)
+            throw std::runtime_error("stbi_loadf failed");
+
+        const double loadNs = bench::NanosecondsPerIteration(iterations, [&](int)
+        {
+            stbi_image_free(stbi_loadf_from_memory(file.data(), (int)file.size(), &w, &h, &channels, 3));
+        });
+        std::printf("  %-36s %10.3f %10.1f\n", "stbi_loadf", loadNs / 1e6, megapixels / (loadNs / 1e9));
+
+        // Conversion
+        /*---------------------------------*/
+        const size_t values = (size_t)width * height * 3;
+        std::vector<uint16_t> scalar(values), simd(values);
+        const double scalarNs = bench::NanosecondsPerIteration(iterations, [&](int)
+        {
+            for (size_t i = 0; i < values; ++i)
+                scalar[i] = glm::packHalf1x16(floats.get()[i]);
+        });
+        const double simdNs = bench::NanosecondsPerIteration(iterations, [&](int)
+        {
+            FloatToHalf(floats.get(), simd.data(), values);
+        });
+        const size_t differences = values - std::inner_product(scalar.begin(), scalar.end(), simd.begin(), (size_t)0,
+                                                               std::plus<size_t>(), std::equal_to<uint16_t>());
+        std::printf("  %-36s %10.3f %10.1f\n", "glm::packHalf1x16", scalarNs / 1e6, megapixels / (scalarNs / 1e9));
+        std::printf("  %-36s %10.3f %10.1f   (%zu values differ)\n", "FloatToHalf", simdNs / 1e6,
+                    megapixels / (simdNs / 1e9), differences);
+
+        // Decode to halves; parallelFor runs on the caller too
+        /*---------------------------------*/
+        const size_t hardware = ThreadPool::hardwareThreads();
+        ThreadPool pool(std::max<size_t>(hardware, 2) - 1);
+        ImageDecodeOptions options;
+        options.FlipVertically = true;
+
+        const double singleNs = bench::NanosecondsPerIteration(iterations, [&](int)
+        {
+            ImageDecoder::decodeHalf(file.data(), file.size(), options);
+        });
+        const double pooledNs = bench::NanosecondsPerIteration(iterations, [&](int)
+        {
+            ImageDecoder::decodeHalf(file.data(), file.size(), options, &pool);
+        });
+        char name[64];
+        std::printf("  %-36s %10.3f %10.1f\n", "decodeHalf, 1 thread", singleNs / 1e6, megapixels / (singleNs / 1e9));
+        std::snprintf(name, sizeof(name), "decodeHalf, %zu threads", pool.size() + 1);
+        std::printf("  %-36s %10.3f %10.1f\n", name, pooledNs / 1e6, megapixels / (pooledNs / 1e9));
+
+        // Uploads
+        /*---------------------------------*/
+        ImageDecodeOptions rgba = options;
+        rgba.Channels = 4;
+        const HalfPixels rgbHalves  = ImageDecoder::decodeHalf(file.data(), file.size(), options, &pool);
+        const HalfPixels rgbaHalves = ImageDecoder::decodeHalf(file.data(), file.size(), rgba, &pool);
+
+        struct Variant
+        {
+            const char * Name;
+            GLint  Internal;
+            GLenum Format;
+            GLenum Type;
+            const void * Pixels;
+            size_t Bytes;
+        };
+        const Variant variants[] =
+        {
+            { "GL_RGB32F from floats",   GL_RGB32F,  GL_RGB,  GL_FLOAT,      floats.get(),           values * sizeof(float) },
+            { "GL_RGB16F from halves",   GL_RGB16F,  GL_RGB,  GL_HALF_FLOAT, rgbHalves.Data.data(),  rgbHalves.size()       },
+            { "GL_RGBA16F from halves",  GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, rgbaHalves.Data.data(), rgbaHalves.size()      },
+        };
+
+        std::printf("\n  %-36s %10s %10s %10s\n", "", "ms", "MP/s", "MB");
+        for (const Variant& variant : variants)
+        {
+            GLTexture texture = GLTexture::create();
+            GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+            glTexImage2D(GL_TEXTURE_2D, 0, variant.Internal, width, height, 0, variant.Format, variant.Type, NULL);
+
+            auto upload = [&](int)
+            {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, variant.Format, variant.Type, variant.Pixels);
+            };
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, UnpackAlignmentFor(variant.Bytes / height, (uintptr_t)variant.Pixels));
+            upload(0);
+            const double ns = bench::NanosecondsPerIteration(iterations, upload);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+            std::printf("  %-36s %10.3f %10.1f %10.1f\n", variant.Name, ns / 1e6, megapixels / (ns / 1e9),
+                        variant.Bytes / 1e6);
+        }
+
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
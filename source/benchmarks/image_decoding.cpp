@@ -0,0 +1,226 @@
+//
+//  image_decoding.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/17/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Decoding every image in a directory (images/ by default) from
+//  memory into a destination buffer, the way the loader fills its
+//  pixel buffers:
+//
+//    - per image, stbi's flip pass then a copy, against ImageDecoder
+//      flipping (and, but for JPEG, expanding to RGBA) in the copy;
+//    - all images, `copies` times over, on 1 to N threads with the
+//      flip alternating per decode. Every result is checked against a
+//      single threaded decode, so a race on flip state would show.
+//
+//      image_decoding [image dir] [copies]
+//
+
+#include "bench.h"
+#include "Hash.h"
+#include "ImageDecoder.h"
+#include "ThreadPool.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                paths.push_back(directory + "/" + name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+struct EncodedFile
+{
+    std::string Path;
+    std::vector<char> Data;
+    int Width    = 0;
+    int Height   = 0;
+    int Channels = 0;
+};
+
+// Decodes into destination; the hash covers what was written
+static uint64_t Decode(const EncodedFile& file, bool flip, std::vector<unsigned char>& destination)
+{
+    ImageDecodeOptions options;
+    options.FlipVertically = flip;
+    const DecodedPixels pixels = ImageDecoder::decode(file.Data.data(), file.Data.size(), options);
+    if (!pixels.isValid())
+        return 0;
+    destination.resize(pixels.size());
+    pixels.writeRows(destination.data());
+    return HashBytes(destination.data(), destination.size());
+}
+
+int main(int argc, const char * argv[])
+{
+    const std::string directory = argc > 1 ? argv[1] : "images";
+    const int copies = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+
+    try
+    {
+        std::vector<EncodedFile> files;
+        for (const std::string& path : ListImages(directory))
+        {
+            std::ifstream stream(path, std::ios::binary);
+            EncodedFile file;
+            file.Path = path;
+            file.Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+            if (!stbi_info_from_memory(reinterpret_cast<const stbi_uc *>(file.Data.data()), (int)file.Data.size(),
+                                       &file.Width, &file.Height, &file.Channels))
+                throw std::runtime_error("Failed to read " + path);
+            files.push_back(std::move(file));
+        }
+        if (files.empty())
+            throw std::runtime_error("No images in " + directory);
+
+        // Per image, one thread
+        /*---------------------------------*/
+        const int iterations = copies;
+        std::printf("%-28s %-24s %10s %10s\n", "image", "path", "ms", "MP/s");
+        for (const EncodedFile& file : files)
+        {
+            const double megapixels = (double)file.Width * file.Height / 1e6;
+            const size_t native = (size_t)file.Width * file.Height * file.Channels;
+            const size_t rgba   = (size_t)file.Width * file.Height * 4;
+            std::vector<unsigned char> destination(rgba);
+
+            struct Variant
+            {
+                const char * Name;
+                bool Stbi;
+                int  Channels;
+            };
+            const Variant variants[] =
+            {
+                { "stbi flip, copy",          true,  0 },
+                { "writeRows flip",           false, 0 },
+                { "stbi flip + RGBA, copy",   true,  4 },
+                { "writeRows flip + RGBA",    false, 4 },
+            };
+
+            for (const Variant& variant : variants)
+            {
+                if (variant.Channels == 4 && file.Channels == 4)
+                    continue;
+
+                auto decode = [&](int)
+                {
+                    if (variant.Stbi)
+                    {
+                        int width, height, channels;
+                        stbi_set_flip_vertically_on_load_thread(1);
+                        unsigned char * pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(file.Data.data()),
+                                                                       (int)file.Data.size(), &width, &height, &channels,
+                                                                       variant.Channels);
+                        std::memcpy(destination.data(), pixels, variant.Channels ? rgba : native);
+                        stbi_image_free(pixels);
+                    }
+                    else
+                    {
+                        ImageDecodeOptions options;
+                        options.FlipVertically = true;
+                        options.Channels = variant.Channels;
+                        ImageDecoder::decode(file.Data.data(), file.Data.size(), options).writeRows(destination.data());
+                    }
+                };
+
+                decode(0);
+                bench::Clock::time_point start = bench::Clock::now();
+                for (int i = 0; i < iterations; ++i)
+                    decode(i);
+                const double ms = bench::MillisecondsSince(start) / iterations;
+                std::printf("%-28s %-24s %10.2f %10.1f\n", file.Path.c_str(), variant.Name, ms, megapixels / (ms / 1000.0));
+            }
+        }
+
+        // Scaling
+        /*---------------------------------*/
+        std::vector<uint64_t> expected[2];
+        double totalMegapixels = 0.0;
+        for (const EncodedFile& file : files)
+        {
+            std::vector<unsigned char> destination;
+            expected[0].push_back(Decode(file, false, destination));
+            expected[1].push_back(Decode(file, true, destination));
+            totalMegapixels += (double)file.Width * file.Height / 1e6 * copies;
+        }
+
+        // At least 4 threads, even oversubscribed, so the race check runs
+        const size_t hardware = ThreadPool::hardwareThreads();
+        std::vector<size_t> threadCounts;
+        for (size_t threads = 1; threads < std::max<size_t>(hardware, 4); threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(std::max<size_t>(hardware, 4));
+
+        const size_t tasks = files.size() * copies;
+        std::printf("\n%zu decodes, %zu hardware thread(s)\n", tasks, hardware);
+        std::printf("%-10s %12s %12s %10s %10s\n", "threads", "ms", "MP/s", "speedup", "mismatch");
+
+        double baseMs = 0.0;
+        for (size_t threads : threadCounts)
+        {
+            // parallelFor runs on the caller too
+            std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+            std::atomic<int> mismatches(0);
+
+            auto body = [&](size_t begin, size_t end)
+            {
+                std::vector<unsigned char> destination;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const size_t index = i % files.size();
+                    const bool flip = (i / files.size()) % 2 == 1;
+                    if (Decode(files[index], flip, destination) != expected[flip][index])
+                        ++mismatches;
+                }
+            };
+
+            bench::Clock::time_point start = bench::Clock::now();
+            if (pool)
+                pool->parallelFor(tasks, body);
+            else
+                body(0, tasks);
+            const double ms = bench::MillisecondsSince(start);
+            if (threads == 1)
+                baseMs = ms;
+
+            std::printf("%-10zu %12.1f %12.1f %9.2fx %10d\n", threads, ms, totalMegapixels / (ms / 1000.0),
+                        baseMs / ms, mismatches.load());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    return 0;
+}
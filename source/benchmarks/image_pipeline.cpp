@@ -0,0 +1,393 @@
+//
+//  image_pipeline.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/23/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  The baseline for the texture pipeline: what stb_image and the driver
+//  cost on the images in a directory (images/ by default), before any
+//  of our own decoding or upload work.
+//
+//    decode     per image, stbi from a FILE*, from a mapped file and
+//               from memory, the last with stbi's SIMD and without it
+//               (stb_image_scalar.cpp, built with STBI_NO_SIMD)
+//    parallel   every image, 8 times over, from memory on 1 to N threads,
+//               SIMD and scalar
+//    upload     glTexImage2D of each decoded image into a new texture:
+//               its own channels and RGBA; HDR as RGB32F and RGB16F
+//
+//  JPEG, PNG and Radiance HDR are timed. With no .hdr in the directory
+//  a procedural sky stands in for one.
+//
+//  A table goes to stdout and every row to `results` as CSV, one line
+//  per measurement, for comparing runs:
+//
+//      stage,image,format,variant,threads,ms,mp_per_s,bytes
+//
+//      image_pipeline [image dir] [iterations] [results]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "MappedFile.h"
+#include "PixelUpload.h"
+#include "ThreadPool.h"
+#include "stb_image_scalar.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "hdr")
+                paths.push_back(directory + "/" + name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Flat RGBE: a gradient sky with a sun far brighter than 1
+static std::vector<char> MakeRadianceSky(int width, int height)
+{
+    const std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) +
+                               " +X " + std::to_string(width) + "\n";
+    std::vector<char> file(header.begin(), header.end());
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float up  = 1.0f - (float)y / height;
+            const float dx  = (float)x / width - 0.3f;
+            const float dy  = up - 0.7f;
+            const float sun = dx * dx + dy * dy < 0.0004f ? 5000.0f : 0.0f;
+            const float rgb[3] = { 0.2f + 0.7f * up + sun, 0.4f + 0.6f * up + sun, 1.0f + 0.2f * up + sun };
+
+            int exponent;
+            const float largest = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+            const float scale = std::frexp(largest, &exponent) * 256.0f / largest;
+            file.push_back((char)(unsigned char)(rgb[0] * scale));
+            file.push_back((char)(unsigned char)(rgb[1] * scale));
+            file.push_back((char)(unsigned char)(rgb[2] * scale));
+            file.push_back((char)(unsigned char)(exponent + 128));
+        }
+    }
+    return file;
+}
+
+struct Image
+{
+    std::string Name;
+    std::string Path;           // empty if generated
+    std::string Format;
+    std::vector<char> Data;
+    int  Width    = 0;
+    int  Height   = 0;
+    int  Channels = 0;
+    bool Hdr      = false;
+
+    const stbi_uc * bytes() const { return reinterpret_cast<const stbi_uc *>(Data.data()); }
+    double megapixels() const     { return (double)Width * Height / 1e6; }
+};
+
+static std::string FormatOf(const std::vector<char>& data)
+{
+    const stbi_uc * bytes = reinterpret_cast<const stbi_uc *>(data.data());
+    if (data.size() >= 2 && bytes[0] == 0xFF && bytes[1] == 0xD8)
+        return "jpeg";
+    if (data.size() >= 4 && bytes[0] == 0x89 && bytes[1] == 'P' && bytes[2] == 'N' && bytes[3] == 'G')
+        return "png";
+    if (stbi_is_hdr_from_memory(bytes, (int)data.size()))
+        return "hdr";
+    return "other";
+}
+
+// Frees whatever either copy of stbi returned; both use free()
+struct Decoded
+{
+    void * Pixels = nullptr;
+    ~Decoded() { stbi_image_free(Pixels); }
+};
+
+static void DecodeFromMemory(const Image& image, bool simd, Decoded& out)
+{
+    int width, height, channels;
+    if (image.Hdr)
+        out.Pixels = simd ? (void *)stbi_loadf_from_memory(image.bytes(), (int)image.Data.size(), &width, &height, &channels, 0)
+                          : (void *)stbi_scalar::loadfFromMemory(image.bytes(), (int)image.Data.size(), &width, &height, &channels, 0);
+    else
+        out.Pixels = simd ? (void *)stbi_load_from_memory(image.bytes(), (int)image.Data.size(), &width, &height, &channels, 0)
+                          : (void *)stbi_scalar::loadFromMemory(image.bytes(), (int)image.Data.size(), &width, &height, &channels, 0);
+    if (!out.Pixels)
+        throw std::runtime_error("Failed to decode " + image.Name);
+}
+
+struct Result
+{
+    std::string Stage;
+    std::string Image;
+    std::string Format;
+    std::string Variant;
+    size_t Threads;
+    double Ms;
+    double Megapixels;
+    size_t Bytes;
+};
+
+int main(int argc, const char * argv[])
+{
+    const std::string directory = argc > 1 ? argv[1] : "images";
+    const int iterations        = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+    const std::string output    = argc > 3 ? argv[3] : "image_pipeline.csv";
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+        stbi_set_flip_vertically_on_load_thread(0);
+
+        std::vector<Image> images;
+        for (const std::string& path : ListImages(directory))
+        {
+            std::ifstream stream(path, std::ios::binary);
+            Image image;
+            image.Name = path.substr(path.rfind('/') + 1);
+            image.Path = path;
+            image.Data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+            images.push_back(std::move(image));
+        }
+        if (std::none_of(images.begin(), images.end(), [](const Image& image) { return FormatOf(image.Data) == "hdr"; }))
+        {
+            Image sky;
+            sky.Name = "sky.hdr (generated)";
+            sky.Data = MakeRadianceSky(1024, 512);
+            images.push_back(std::move(sky));
+        }
+
+        for (Image& image : images)
+        {
+            image.Format = FormatOf(image.Data);
+            image.Hdr    = image.Format == "hdr";
+            if (!stbi_info_from_memory(image.bytes(), (int)image.Data.size(), &image.Width, &image.Height, &image.Channels))
+                throw std::runtime_error("Failed to read " + image.Name);
+        }
+
+        std::vector<Result> results;
+        auto report = [&](const Result& result)
+        {
+            std::printf("%-10s %-24s %-6s %-20s %7zu %10.3f %10.1f\n", result.Stage.c_str(), result.Image.c_str(),
+                        result.Format.c_str(), result.Variant.c_str(), result.Threads, result.Ms,
+                        result.Megapixels / (result.Ms / 1000.0));
+            results.push_back(result);
+        };
+        std::printf("%-10s %-24s %-6s %-20s %7s %10s %10s\n", "stage", "image", "format", "variant", "threads", "ms", "MP/s");
+
+        // Decode: one image, one thread
+        /*---------------------------------*/
+        for (const Image& image : images)
+        {
+            const size_t bytes = image.Data.size();
+
+            // The generated sky has no path; give FILE* a temporary copy
+            FILE * file = image.Path.empty() ? std::tmpfile() : std::fopen(image.Path.c_str(), "rb");
+            if (!file)
+                throw std::runtime_error("Failed to open " + image.Name);
+            if (image.Path.empty())
+                std::fwrite(image.Data.data(), 1, bytes, file);
+
+            const double fileNs = bench::NanosecondsPerIteration(iterations, [&](int)
+            {
+                int width, height, channels;
+                std::rewind(file);
+                Decoded decoded;
+                decoded.Pixels = image.Hdr ? (void *)stbi_loadf_from_file(file, &width, &height, &channels, 0)
+                                           : (void *)stbi_load_from_file(file, &width, &height, &channels, 0);
+            });
+            std::fclose(file);
+            report({ "decode", image.Name, image.Format, "file", 1, fileNs / 1e6, image.megapixels(), bytes });
+
+            if (!image.Path.empty())
+            {
+                const double mappedNs = bench::NanosecondsPerIteration(iterations, [&](int)
+                {
+                    MappedFile mapped(image.Path);
+                    const stbi_uc * data = reinterpret_cast<const stbi_uc *>(mapped.data());
+                    int width, height, channels;
+                    Decoded decoded;
+                    decoded.Pixels = image.Hdr ? (void *)stbi_loadf_from_memory(data, (int)mapped.size(), &width, &height, &channels, 0)
+                                               : (void *)stbi_load_from_memory(data, (int)mapped.size(), &width, &height, &channels, 0);
+                });
+                report({ "decode", image.Name, image.Format, "mapped", 1, mappedNs / 1e6, image.megapixels(), bytes });
+            }
+
+            for (bool simd : { true, false })
+            {
+                const double ns = bench::NanosecondsPerIteration(iterations, [&](int)
+                {
+                    Decoded decoded;
+                    DecodeFromMemory(image, simd, decoded);
+                });
+                report({ "decode", image.Name, image.Format, simd ? "memory" : "memory, no simd", 1, ns / 1e6,
+                         image.megapixels(), bytes });
+            }
+        }
+
+        // Parallel: all images, 8 copies each, from memory
+        /*---------------------------------*/
+        const size_t copies = 8;
+        const size_t tasks  = images.size() * copies;
+        size_t totalBytes = 0;
+        double totalMegapixels = 0.0;
+        for (const Image& image : images)
+        {
+            totalBytes      += image.Data.size() * copies;
+            totalMegapixels += image.megapixels() * copies;
+        }
+
+        const size_t hardware = ThreadPool::hardwareThreads();
+        std::vector<size_t> threadCounts;
+        for (size_t threads = 1; threads < hardware; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(hardware);
+
+        for (bool simd : { true, false })
+        {
+            for (size_t threads : threadCounts)
+            {
+                // parallelFor runs on the caller too
+                std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+                auto body = [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        Decoded decoded;
+                        DecodeFromMemory(images[i % images.size()], simd, decoded);
+                    }
+                };
+
+                const double ns = bench::NanosecondsPerIteration(1, [&](int)
+                {
+                    if (pool)
+                        pool->parallelFor(tasks, body);
+                    else
+                        body(0, tasks);
+                });
+                report({ "parallel", "all", "mixed", simd ? "memory" : "memory, no simd", threads, ns / 1e6,
+                         totalMegapixels, totalBytes });
+            }
+        }
+
+        // Upload: a new texture per call, as the loader makes them
+        /*---------------------------------*/
+        for (const Image& image : images)
+        {
+            struct Variant
+            {
+                const char * Name;
+                int Channels;
+                PixelFormat Format;
+                size_t TexelBytes;
+            };
+            std::vector<Variant> variants;
+            if (image.Hdr)
+            {
+                variants.push_back({ "rgb32f", 3, { GL_RGB32F, GL_RGB, GL_FLOAT }, 12 });
+                variants.push_back({ "rgb16f", 3, HalfFormatFor(3), 6 });
+            }
+            else
+            {
+                variants.push_back({ "native", image.Channels, PixelFormatFor(image.Channels), (size_t)image.Channels });
+                if (image.Channels != 4)
+                    variants.push_back({ "rgba", 4, PixelFormatFor(4), 4 });
+            }
+
+            for (const Variant& variant : variants)
+            {
+                int width, height, channels;
+                Decoded decoded;
+                std::vector<uint16_t> halves;
+                const void * pixels;
+                if (image.Hdr)
+                {
+                    decoded.Pixels = stbi_loadf_from_memory(image.bytes(), (int)image.Data.size(), &width, &height, &channels, 3);
+                    if (variant.Format.Type == GL_HALF_FLOAT)
+                    {
+                        halves.resize((size_t)width * height * 3);
+                        FloatToHalf(static_cast<const float *>(decoded.Pixels), halves.data(), halves.size());
+                    }
+                    pixels = halves.empty() ? decoded.Pixels : (const void *)halves.data();
+                }
+                else
+                {
+                    decoded.Pixels = stbi_load_from_memory(image.bytes(), (int)image.Data.size(), &width, &height, &channels,
+                                                           variant.Channels);
+                    pixels = decoded.Pixels;
+                }
+
+                const size_t rowBytes = (size_t)width * variant.TexelBytes;
+                glPixelStorei(GL_UNPACK_ALIGNMENT, UnpackAlignmentFor(rowBytes, (uintptr_t)pixels));
+                auto upload = [&](int)
+                {
+                    GLTexture texture = GLTexture::create();
+                    GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+                    glTexImage2D(GL_TEXTURE_2D, 0, variant.Format.Internal, width, height, 0, variant.Format.Format,
+                                 variant.Format.Type, pixels);
+                };
+                upload(0);
+                const double ns = bench::NanosecondsPerIteration(iterations, upload);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                GLDeletions.flush();
+
+                report({ "upload", image.Name, image.Format, variant.Name, 1, ns / 1e6, image.megapixels(),
+                         rowBytes * height });
+            }
+        }
+
+        // Machine readable
+        /*---------------------------------*/
+        std::ofstream csv(output);
+        if (!csv)
+            throw std::runtime_error("Failed to write " + output);
+        csv << "stage,image,format,variant,threads,ms,mp_per_s,bytes\n";
+        for (const Result& result : results)
+        {
+            csv << result.Stage << ",\"" << result.Image << "\"," << result.Format << ",\"" << result.Variant << "\","
+                << result.Threads << "," << result.Ms << "," << result.Megapixels / (result.Ms / 1000.0) << ","
+                << result.Bytes << "\n";
+        }
+        std::printf("\n%zu results written to %s\n", results.size(), output.c_str());
+
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,139 @@
+//
+//  mip_generation.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/9/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Throughput of GenerateMipChain for every image in a directory
+//  (images/ by default): box and Kaiser, with and without sRGB
+//  conversion, on one thread and on a pool, next to the driver's
+//  glGenerateMipmap. Rates are top level megapixels per second.
+//
+//      mip_generation [image dir] [iterations]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+#include "MipChain.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                paths.push_back(directory + "/" + name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+int main(int argc, const char * argv[])
+{
+    const std::string directory = argc > 1 ? argv[1] : "images";
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        const std::vector<std::string> paths = ListImages(directory);
+        if (paths.empty())
+            throw std::runtime_error("No images in " + directory);
+
+        // parallelFor runs on the caller too
+        ThreadPool pool(std::max<size_t>(1, ThreadPool::hardwareThreads() - 1));
+        std::printf("%d iterations, pool of %zu + caller\n", iterations, pool.size());
+
+        struct Variant
+        {
+            const char * Name;
+            MipFilter    Filter;
+            bool         Srgb;
+            bool         Threaded;
+        };
+        const Variant variants[] =
+        {
+            { "box, unconverted",        MipFilter::Box,    false, false },
+            { "box, sRGB",               MipFilter::Box,    true,  false },
+            { "box, sRGB, pool",         MipFilter::Box,    true,  true  },
+            { "kaiser, sRGB",            MipFilter::Kaiser, true,  false },
+            { "kaiser, sRGB, pool",      MipFilter::Kaiser, true,  true  },
+        };
+
+        for (const std::string& path : paths)
+        {
+            DecodedPixels pixels = ImageDecoder::decodeFile(path);
+            if (!pixels.isValid())
+                throw std::runtime_error("Failed to decode " + path + ": " + pixels.error());
+
+            const unsigned char * data = pixels.data();
+            const int width = pixels.width(), height = pixels.height(), channels = pixels.channels();
+
+            const double megapixels = (double)width * height / 1e6;
+            std::printf("\n%s: %dx%d, %d channel(s)\n", path.c_str(), width, height, channels);
+            std::printf("  %-26s %10s %10s\n", "", "ms", "MP/s");
+
+            for (const Variant& variant : variants)
+            {
+                MipOptions options;
+                options.Filter = variant.Filter;
+                options.Srgb   = variant.Srgb;
+                options.Pool   = variant.Threaded ? &pool : nullptr;
+
+                GenerateMipChain(data, width, height, channels, options);     // warm the tables
+                bench::Clock::time_point start = bench::Clock::now();
+                for (int i = 0; i < iterations; ++i)
+                    GenerateMipChain(data, width, height, channels, options);
+                const double ms = bench::MillisecondsSince(start) / iterations;
+
+                std::printf("  %-26s %10.2f %10.1f\n", variant.Name, ms, megapixels / (ms / 1000.0));
+            }
+
+            // The driver, for reference: upload included, sRGB ignored
+            const GLenum format = channels == 4 ? GL_RGBA : channels == 3 ? GL_RGB : channels == 2 ? GL_RG : GL_RED;
+            GLTexture texture = GLTexture::create();
+            GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            const double ns = bench::NanosecondsPerIteration(iterations, [&](int)
+            {
+                glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+                glGenerateMipmap(GL_TEXTURE_2D);
+            });
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            std::printf("  %-26s %10.2f %10.1f\n", "glGenerateMipmap + upload", ns / 1e6, megapixels / (ns / 1e9));
+        }
+
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
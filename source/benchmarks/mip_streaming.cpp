@@ -0,0 +1,152 @@
+//
+//  mip_streaming.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/24/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Frame times while a scene's textures load: every image in a
+//  directory (images/ by default), `copies` times over, through
+//  TextureLoader whole and with TextureParams::Stream at a few stream
+//  budgets. Each copy is given a different screen size, so streaming
+//  should bring the largest on screen to full detail first.
+//
+//  Reports the GL thread's time in update(), in all and per frame (99th
+//  percentile, worst), frames until every texture is complete, and the
+//  frame at which the largest and the smallest on screen got there.
+//
+//      mip_streaming [image dir] [copies]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tex")
+                paths.push_back(directory + "/" + name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Stands in for a frame: clear and wait, as a swap would
+static void Frame()
+{
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+}
+
+int main(int argc, const char * argv[])
+{
+    const std::string directory = argc > 1 ? argv[1] : "images";
+    const int copies = argc > 2 ? std::max(1, std::atoi(argv[2])) : 16;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        const std::vector<std::string> images = ListImages(directory);
+        if (images.empty())
+            throw std::runtime_error("No images in " + directory);
+
+        std::vector<std::string> paths;
+        for (int copy = 0; copy < copies; ++copy)
+            paths.insert(paths.end(), images.begin(), images.end());
+        std::printf("%zu images x %d copies = %zu textures\n\n", images.size(), copies, paths.size());
+
+        struct Variant
+        {
+            const char * Name;
+            bool   Stream;
+            size_t Budget;
+        };
+        const Variant variants[] =
+        {
+            { "whole",                false, 0         },
+            { "stream, 256 KB/frame", true,  256 << 10 },
+            { "stream, 1 MB/frame",   true,  1 << 20   },
+            { "stream, 4 MB/frame",   true,  4 << 20   },
+        };
+
+        std::printf("%-22s %9s %9s %9s %8s %9s %9s\n", "", "total ms", "p99 ms", "worst ms", "frames", "largest", "smallest");
+        for (const Variant& variant : variants)
+        {
+            TextureLoader loader;
+            loader.setStreamBudget(variant.Budget);
+
+            TextureParams params;
+            params.Stream = variant.Stream;
+
+            // Screen sizes from 2048 down to 16 pixels, spread over the copies
+            std::vector<std::shared_ptr<Texture>> textures;
+            for (size_t i = 0; i < paths.size(); ++i)
+            {
+                textures.push_back(loader.load(paths[i], params));
+                textures.back()->setScreenSize(2048.0f / (float)(1 << (i * 8 / paths.size())));
+            }
+
+            std::vector<double> updateMs;
+            int largestDone = 0, smallestDone = 0;
+            while (loader.pending() > 0 || loader.streaming() > 0 || updateMs.empty())
+            {
+                bench::Clock::time_point start = bench::Clock::now();
+                loader.update();
+                updateMs.push_back(bench::MillisecondsSince(start));
+
+                for (const auto& texture : textures)
+                    texture->bind(0);
+                Frame();
+
+                const int frame = (int)updateMs.size();
+                const Texture& largest  = *textures.front();
+                const Texture& smallest = *textures.back();
+                if (!largestDone && largest.isReady() && largest.baseLevel() == 0)
+                    largestDone = frame;
+                if (!smallestDone && smallest.isReady() && smallest.baseLevel() == 0)
+                    smallestDone = frame;
+            }
+
+            double total = 0.0;
+            for (double ms : updateMs)
+                total += ms;
+            std::vector<double> sorted = updateMs;
+            std::sort(sorted.begin(), sorted.end());
+
+            std::printf("%-22s %9.3f %9.3f %9.3f %8zu %9d %9d\n", variant.Name, total,
+                        sorted[sorted.size() * 99 / 100], sorted.back(), updateMs.size(), largestDone, smallestDone);
+
+            textures.clear();
+            GLDeletions.flush();
+        }
+
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
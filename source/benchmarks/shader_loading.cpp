@@ -0,0 +1,196 @@
+//
+//  shader_loading.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 6/14/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Time and heap allocations to get a few hundred shader files from
+//  disk into glShaderSource. The old path checked each file with
+//  fopen, then read it through ifstream + stringstream into a string;
+//  the new one maps each file once and hands the spans straight over.
+//  Files are warm in the page cache after the first pass, so this
+//  measures the copies rather than the disk.
+//
+
+#include "bench.h"
+#include "ShaderPreprocessor.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const int FILE_COUNT = 400;
+const int PASSES     = 10;
+
+// Every heap allocation in the process goes through here
+/*---------------------------------*/
+static std::atomic<size_t> Allocations(0);
+static std::atomic<size_t> AllocatedBytes(0);
+
+void* operator new(std::size_t size)
+{
+    ++Allocations;
+    AllocatedBytes += size;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// ~8KB fragment shaders, unique per index
+static std::vector<std::string> WriteShaders()
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < FILE_COUNT; ++i)
+    {
+        std::string path = "bench_load_" + std::to_string(i) + ".fs";
+        if (FILE *out = ::fopen(path.c_str(), "w"))
+        {
+            fputs("#version 330 core\nlayout(location = 0) out vec4 Color;\nuniform vec4 uValues[64];\n", out);
+            fputs("void main()\n{\n    vec4 sum = vec4(0.0);\n", out);
+            for (int line = 0; line < 160; ++line)
+                fprintf(out, "    sum += uValues[%d] * %d.0; // accumulate term %d of shader %d\n", line % 64, line + i, line, i);
+            fputs("    Color = sum;\n}\n", out);
+            fclose(out);
+        }
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+// What Shader used to do per file
+/*---------------------------------*/
+static bool LegacyLoad(const std::string& path, std::string& code)
+{
+    if (FILE *file = ::fopen(path.c_str(), "r"))
+        fclose(file);
+    else
+        return false;
+
+    std::ifstream stream;
+    stream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try
+    {
+        stream.open(path);
+        std::stringstream buffer;
+        buffer << stream.rdbuf();
+        stream.close();
+        code = buffer.str();
+    }
+    catch (std::ifstream::failure&)
+    {
+        return false;
+    }
+    return true;
+}
+
+struct Result
+{
+    double Ms;
+    double AllocationsPerFile;
+    double BytesPerFile;
+};
+
+// Load every file, optionally handing it to glShaderSource, PASSES times
+template <typename Load>
+static Result Measure(const std::vector<std::string>& paths, GLuint shader, Load load)
+{
+    const size_t allocations = Allocations;
+    const size_t bytes       = AllocatedBytes;
+
+    glFinish();
+    bench::Clock::time_point start = bench::Clock::now();
+    for (int pass = 0; pass < PASSES; ++pass)
+        for (const std::string& path : paths)
+            load(path, shader);
+    glFinish();
+
+    const double files = double(PASSES) * paths.size();
+    return { bench::MillisecondsSince(start) / PASSES,
+             (Allocations - allocations) / files,
+             (AllocatedBytes - bytes) / files };
+}
+
+static void Print(const char * name, const Result& result)
+{
+    std::printf("%-28s %10.2f %12.1f %12.0f\n", name, result.Ms, result.AllocationsPerFile, result.BytesPerFile);
+}
+
+int main(int argc, const char * argv[])
+{
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        std::vector<std::string> paths = WriteShaders();
+        GLuint shader = glCreateShader(GL_FRAGMENT_SHADER);
+
+        auto legacyRead = [](const std::string& path, GLuint)
+        {
+            std::string code;
+            LegacyLoad(path, code);
+        };
+        auto legacySource = [](const std::string& path, GLuint shader)
+        {
+            std::string code;
+            if (LegacyLoad(path, code))
+            {
+                const char* text = code.c_str();
+                glShaderSource(shader, 1, &text, NULL);
+            }
+        };
+        auto mapOnly = [](const std::string& path, GLuint)
+        {
+            MappedFile file(path);
+        };
+        auto mappedRead = [](const std::string& path, GLuint)
+        {
+            PreprocessedSource source;
+            ShaderPreprocessor::expand(path, {}, source);
+        };
+        auto mappedSource = [](const std::string& path, GLuint shader)
+        {
+            PreprocessedSource source;
+            if (ShaderPreprocessor::expand(path, {}, source))
+                glShaderSource(shader, (GLsizei)source.Strings.size(), source.Strings.data(), source.Lengths.data());
+        };
+
+        // Warm the page cache so neither path pays for the first read
+        Measure(paths, shader, legacyRead);
+
+        std::printf("%d files x %d passes, per pass:\n", FILE_COUNT, PASSES);
+        std::printf("%-28s %10s %12s %12s\n", "path", "ms", "allocs/file", "bytes/file");
+        Print("ifstream read",                  Measure(paths, shader, legacyRead));
+        Print("mmap",                           Measure(paths, shader, mapOnly));
+        Print("mmap + preprocess",              Measure(paths, shader, mappedRead));
+        Print("ifstream + glShaderSource",      Measure(paths, shader, legacySource));
+        Print("mmap + glShaderSource",          Measure(paths, shader, mappedSource));
+
+        glDeleteShader(shader);
+        for (const std::string& path : paths)
+            std::remove(path.c_str());
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,43 @@
+//
+//  stb_image_scalar.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/23/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  STB_IMAGE_STATIC keeps this copy's symbols out of the way of the
+//  one source/stb_image.cpp compiles. Link both.
+//
+
+#include "stb_image_scalar.h"
+
+#if defined(__GNUC__)
+    #pragma GCC diagnostic ignored "-Wunused-function"
+#endif
+
+#define STB_IMAGE_STATIC
+#define STBI_NO_SIMD
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace stbi_scalar
+{
+    unsigned char * loadFromMemory(const unsigned char * data, int size, int * width, int * height, int * channels,
+                                   int requested)
+    {
+        stbi_set_flip_vertically_on_load_thread(0);
+        return stbi_load_from_memory(data, size, width, height, channels, requested);
+    }
+
+    float * loadfFromMemory(const unsigned char * data, int size, int * width, int * height, int * channels,
+                            int requested)
+    {
+        stbi_set_flip_vertically_on_load_thread(0);
+        return stbi_loadf_from_memory(data, size, width, height, channels, requested);
+    }
+
+    void imageFree(void * pixels)
+    {
+        stbi_image_free(pixels);
+    }
+}
@@ -0,0 +1,28 @@
+//
+//  stb_image_scalar.h
+//  Benchmarks
+//
+//  Created by Crunchy on 7/23/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  A second copy of stb_image built with STBI_NO_SIMD, so one program
+//  can time stbi's SSE2/NEON paths against its scalar ones. Everything
+//  it compiles is static to stb_image_scalar.cpp; these are the only
+//  ways in.
+//
+
+#ifndef stb_image_scalar_h
+#define stb_image_scalar_h
+
+namespace stbi_scalar
+{
+    unsigned char * loadFromMemory(const unsigned char * data, int size, int * width, int * height, int * channels,
+                                   int requested);
+
+    float * loadfFromMemory(const unsigned char * data, int size, int * width, int * height, int * channels,
+                            int requested);
+
+    void imageFree(void * pixels);
+}
+
+#endif
@@ -0,0 +1,243 @@
+//
+//  texture_baking.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Compares the runtime cost of a texture straight from its image file
+//  (stbi_load, glTexImage2D, glGenerateMipmap) with a baked container
+//  (mmap, one glTexImage2D per level), raw and block compressed. The
+//  containers are baked into the output directory first, untimed, the
+//  way bake_textures does.
+//
+//      texture_baking [image dir] [baked dir] [iterations]
+//
+
+#include "bench.h"
+#include "BlockCompression.h"
+#include "GLDeletionQueue.h"
+#include "GLExtensions.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "ImageDecoder.h"
+#include "MipChain.h"
+#include "TextureContainer.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> names;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                names.push_back(name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static GLenum FormatFor(int channels)
+{
+    return channels == 4 ? GL_RGBA : channels == 3 ? GL_RGB : channels == 2 ? GL_RG : GL_RED;
+}
+
+struct Timing
+{
+    double ReadMs   = 0.0;     // decode or map
+    double UploadMs = 0.0;     // GL calls, mip generation included
+};
+
+static Timing LoadImage(const std::string& path, std::vector<GLTexture>& textures)
+{
+    Timing timing;
+    bench::Clock::time_point start = bench::Clock::now();
+
+    int width, height, channels;
+    stbi_set_flip_vertically_on_load_thread(1);     // the global is ignored once ImageDecoder has run here
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+    if (!data)
+        throw std::runtime_error("Failed to decode " + path);
+    timing.ReadMs = bench::MillisecondsSince(start);
+
+    start = bench::Clock::now();
+    GLTexture texture = GLTexture::create();
+    GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, FormatFor(channels), width, height, 0, FormatFor(channels), GL_UNSIGNED_BYTE, data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glFinish();
+    timing.UploadMs = bench::MillisecondsSince(start);
+
+    stbi_image_free(data);
+    textures.push_back(std::move(texture));
+    return timing;
+}
+
+static Timing LoadContainer(const std::string& path, std::vector<GLTexture>& textures)
+{
+    Timing timing;
+    bench::Clock::time_point start = bench::Clock::now();
+
+    TextureContainer container(path);
+    if (!container.isOpen())
+        throw std::runtime_error("Failed to map " + path + ": " + container.error());
+    timing.ReadMs = bench::MillisecondsSince(start);
+
+    start = bench::Clock::now();
+    const GLenum format = FormatFor(TextureContainer::channels(container.format()));
+    const GLenum compressed = container.format() == TextureFormat::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+                                                                       : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    GLTexture texture = GLTexture::create();
+    GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < container.levelCount(); ++i)
+    {
+        const TextureLevel level = container.level(i);
+        if (TextureContainer::isCompressed(container.format()))
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, compressed, level.Width, level.Height, 0, (GLsizei)level.Size, level.Data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, (GLint)i, format, level.Width, level.Height, 0, format, GL_UNSIGNED_BYTE, level.Data);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)container.levelCount() - 1);
+    glFinish();
+    timing.UploadMs = bench::MillisecondsSince(start);
+
+    textures.push_back(std::move(texture));
+    return timing;
+}
+
+static size_t FileSize(const std::string& path)
+{
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? (size_t)info.st_size : 0;
+}
+
+int main(int argc, const char * argv[])
+{
+    const std::string imageDirectory = argc > 1 ? argv[1] : "images";
+    const std::string bakedDirectory = argc > 2 ? argv[2] : "baked";
+    const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 10;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+        LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+        if (!GLExt.HasTextureCompressionS3TC)
+            throw std::runtime_error("GL_EXT_texture_compression_s3tc is required");
+
+        const std::vector<std::string> names = ListImages(imageDirectory);
+        if (names.empty())
+            throw std::runtime_error("No images in " + imageDirectory);
+
+        // Bake, untimed
+        /*---------------------------------*/
+        ::mkdir(bakedDirectory.c_str(), 0755);
+        size_t imageBytes = 0, bakedBytes = 0, compressedBytes = 0;
+        for (const std::string& name : names)
+        {
+            ImageDecodeOptions options;
+            options.FlipVertically = true;
+            DecodedPixels pixels = ImageDecoder::decodeFile(imageDirectory + "/" + name, options);
+            if (!pixels.isValid())
+                throw std::runtime_error("Failed to decode " + name + ": " + pixels.error());
+
+            const int channels = pixels.channels();
+            const std::vector<MipImage> chain = GenerateMipChain(pixels.data(), pixels.width(), pixels.height(), channels);
+
+            std::vector<TextureLevel> levels;
+            for (const MipImage& image : chain)
+                levels.push_back(image.level());
+
+            std::string error;
+            const std::string output = bakedDirectory + "/" + name + ".tex";
+            if (!TextureContainer::write(output, static_cast<TextureFormat>(channels), true, 0, levels, error))
+                throw std::runtime_error("Failed to write " + output + ": " + error);
+
+            // And again as blocks
+            const TextureFormat format = channels == 4 ? TextureFormat::BC3 : TextureFormat::BC1;
+            std::vector<std::vector<unsigned char>> blocks;
+            for (TextureLevel& level : levels)
+            {
+                blocks.push_back(CompressBlocks(format, level.Data, level.Width, level.Height, channels));
+                level.Data = blocks.back().data();
+                level.Size = blocks.back().size();
+            }
+
+            const std::string compressed = bakedDirectory + "/" + name + ".bc.tex";
+            if (!TextureContainer::write(compressed, format, true, 0, levels, error))
+                throw std::runtime_error("Failed to write " + compressed + ": " + error);
+
+            imageBytes      += FileSize(imageDirectory + "/" + name);
+            bakedBytes      += FileSize(output);
+            compressedBytes += FileSize(compressed);
+        }
+
+        std::printf("%zu images, %d iterations; %.1f KB of images, %.1f KB baked, %.1f KB compressed\n",
+                    names.size(), iterations, imageBytes / 1024.0, bakedBytes / 1024.0, compressedBytes / 1024.0);
+
+        // Warm the page cache and the driver for both paths
+        std::vector<GLTexture> textures;
+        for (const std::string& name : names)
+        {
+            LoadImage(imageDirectory + "/" + name, textures);
+            LoadContainer(bakedDirectory + "/" + name + ".tex", textures);
+            LoadContainer(bakedDirectory + "/" + name + ".bc.tex", textures);
+        }
+        textures.clear();
+        GLDeletions.flush();
+
+        Timing image, baked, compressed;
+        for (int i = 0; i < iterations; ++i)
+        {
+            for (const std::string& name : names)
+            {
+                const Timing a = LoadImage(imageDirectory + "/" + name, textures);
+                const Timing b = LoadContainer(bakedDirectory + "/" + name + ".tex", textures);
+                const Timing c = LoadContainer(bakedDirectory + "/" + name + ".bc.tex", textures);
+                image.ReadMs      += a.ReadMs;  image.UploadMs      += a.UploadMs;
+                baked.ReadMs      += b.ReadMs;  baked.UploadMs      += b.UploadMs;
+                compressed.ReadMs += c.ReadMs;  compressed.UploadMs += c.UploadMs;
+            }
+            textures.clear();
+            GLDeletions.flush();
+        }
+
+        const double count = (double)iterations * names.size();
+        std::printf("%-34s %12s %12s %12s\n", "ms per texture", "read", "upload", "total");
+        std::printf("%-34s %12.3f %12.3f %12.3f\n", "stbi_load + glGenerateMipmap",
+                    image.ReadMs / count, image.UploadMs / count, (image.ReadMs + image.UploadMs) / count);
+        std::printf("%-34s %12.3f %12.3f %12.3f\n", "mapped container",
+                    baked.ReadMs / count, baked.UploadMs / count, (baked.ReadMs + baked.UploadMs) / count);
+        std::printf("%-34s %12.3f %12.3f %12.3f\n", "mapped BC1/BC3 container",
+                    compressed.ReadMs / count, compressed.UploadMs / count, (compressed.ReadMs + compressed.UploadMs) / count);
+
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,191 @@
+//
+//  texture_loading.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Loads every image in a directory (images/ by default), several
+//  times over, the way the Textures lesson does it (stbi_load and
+//  glTexImage2D on the GL thread before the first frame) and through
+//  TextureLoader, with and without a TextureCache sharing the copies.
+//  Reports time to first frame and time until every texture is
+//  resident.
+//
+//      texture_loading [image dir] [copies]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> paths;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                paths.push_back(directory + "/" + name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Stands in for a frame: clear and wait, as a swap would
+static void Frame()
+{
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glFinish();
+}
+
+int main(int argc, const char * argv[])
+{
+    const std::string directory = argc > 1 ? argv[1] : "images";
+    const int copies = argc > 2 ? std::max(1, std::atoi(argv[2])) : 8;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        std::vector<std::string> images = ListImages(directory);
+        if (images.empty())
+            throw std::runtime_error("No images in " + directory);
+
+        std::vector<std::string> paths;
+        for (int copy = 0; copy < copies; ++copy)
+            paths.insert(paths.end(), images.begin(), images.end());
+
+        std::printf("%zu images x %d copies = %zu textures, %zu worker thread(s)\n",
+                    images.size(), copies, paths.size(), ThreadPool::hardwareThreads());
+
+        // Synchronous: everything loads before the first frame. The
+        // first pass is untimed; it warms the page cache and the driver.
+        /*---------------------------------*/
+        bench::Clock::time_point start;
+        std::vector<GLTexture> textures;
+
+        // The per-thread setter: once ImageDecoder has run on a thread,
+        // stbi ignores the global flip there
+        stbi_set_flip_vertically_on_load_thread(1);
+        for (size_t i = 0; i < images.size() + paths.size(); ++i)
+        {
+            if (i == images.size())
+            {
+                Frame();
+                textures.clear();
+                GLDeletions.flush();
+                start = bench::Clock::now();
+            }
+
+            const std::string& path = i < images.size() ? images[i] : paths[i - images.size()];
+            int width, height, channels;
+            unsigned char *data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+            if (!data)
+                continue;
+
+            GLTexture texture = GLTexture::create();
+            GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+            const GLenum format = channels == 4 ? GL_RGBA : channels == 3 ? GL_RGB : channels == 2 ? GL_RG : GL_RED;
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            stbi_image_free(data);
+            textures.push_back(std::move(texture));
+        }
+        Frame();
+        const double syncMs = bench::MillisecondsSince(start);
+        textures.clear();
+        GLDeletions.flush();
+
+        // Asynchronous: frames run from the start on placeholders
+        /*---------------------------------*/
+        std::printf("%-28s %14s %12s\n", "path", "first frame ms", "total ms");
+        std::printf("%-28s %14.2f %12.2f\n", "stbi_load + glTexImage2D", syncMs, syncMs);
+
+        start = bench::Clock::now();
+        double firstFrameMs = 0.0;
+        int frames = 0;
+        TextureLoaderStats stats;
+        {
+            TextureLoader loader;
+            std::vector<std::shared_ptr<Texture>> loading;
+            for (const std::string& path : paths)
+                loading.push_back(loader.load(path));
+
+            while (loader.pending() > 0 || frames == 0)
+            {
+                loader.update();
+                for (const auto& texture : loading)
+                    texture->bind(0);
+                Frame();
+
+                if (++frames == 1)
+                    firstFrameMs = bench::MillisecondsSince(start);
+            }
+            const double asyncMs = bench::MillisecondsSince(start);
+
+            stats = loader.stats();
+            std::printf("%-28s %14.2f %12.2f\n", "TextureLoader", firstFrameMs, asyncMs);
+        }
+        GLDeletions.flush();
+
+        // Cached: every copy after the first is a hit
+        /*---------------------------------*/
+        const int loaderFrames = frames;
+        start = bench::Clock::now();
+        {
+            TextureLoader loader;
+            TextureCache cache(loader);
+            std::vector<std::shared_ptr<Texture>> loading;
+            for (const std::string& path : paths)
+                loading.push_back(cache.acquire(path));
+
+            frames = 0;
+            while (loader.pending() > 0 || frames == 0)
+            {
+                cache.update();
+                for (const auto& texture : loading)
+                    texture->bind(0);
+                Frame();
+
+                if (++frames == 1)
+                    firstFrameMs = bench::MillisecondsSince(start);
+            }
+            const double cachedMs = bench::MillisecondsSince(start);
+
+            std::printf("%-28s %14.2f %12.2f\n", "TextureCache", firstFrameMs, cachedMs);
+            std::printf("loader: %u uploaded, %u failed, %d frames, decode %.2f ms (all workers), upload %.2f ms, %.1f MB\n",
+                        stats.Uploaded, stats.Failed, loaderFrames, stats.DecodeMs, stats.UploadMs, stats.BytesUploaded / 1048576.0);
+            cache.printStats(std::cout);
+        }
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
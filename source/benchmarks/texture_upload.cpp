@@ -0,0 +1,137 @@
+//
+//  texture_upload.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  glTexSubImage2D throughput for 1, 3 and 4 channel sources, at a
+//  width whose rows are 4 byte aligned in every format and at one
+//  whose rows are not: GL_UNPACK_ALIGNMENT 1 against the alignment
+//  the rows really have, and RGB handed to the driver against RGB
+//  expanded to RGBA first (scalar, and ExpandRGBToRGBA). Expansion
+//  time is included. Also the expansion kernel on its own.
+//
+//      texture_upload [iterations]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "PixelUpload.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static void ExpandScalar(const unsigned char * rgb, unsigned char * rgba, size_t texels)
+{
+    for (size_t i = 0; i < texels; ++i)
+    {
+        rgba[i * 4 + 0] = rgb[i * 3 + 0];
+        rgba[i * 4 + 1] = rgb[i * 3 + 1];
+        rgba[i * 4 + 2] = rgb[i * 3 + 2];
+        rgba[i * 4 + 3] = 255;
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        const int sizes[] = { 1024, 1001 };
+        for (int size : sizes)
+        {
+            const size_t texels = (size_t)size * size;
+            const double megapixels = texels / 1e6;
+
+            std::vector<unsigned char> source(texels * 4);
+            for (size_t i = 0; i < source.size(); ++i)
+                source[i] = (unsigned char)(i * 2654435761u >> 24);
+            std::vector<unsigned char> expanded(texels * 4);
+
+            // Kernel alone
+            /*---------------------------------*/
+            const double scalarNs = bench::NanosecondsPerIteration(iterations, [&](int)
+            {
+                ExpandScalar(source.data(), expanded.data(), texels);
+            });
+            const double simdNs = bench::NanosecondsPerIteration(iterations, [&](int)
+            {
+                ExpandRGBToRGBA(source.data(), expanded.data(), texels);
+            });
+            std::printf("\n%dx%d\n", size, size);
+            std::printf("  %-36s %10s %10s\n", "", "ms", "MP/s");
+            std::printf("  %-36s %10.3f %10.1f\n", "RGB -> RGBA, scalar", scalarNs / 1e6, megapixels / (scalarNs / 1e9));
+            std::printf("  %-36s %10.3f %10.1f\n", "RGB -> RGBA, ExpandRGBToRGBA", simdNs / 1e6, megapixels / (simdNs / 1e9));
+
+            // Uploads
+            /*---------------------------------*/
+            enum class Expand { None, Scalar, Simd };
+            struct Variant
+            {
+                const char * Name;
+                int    Channels;
+                bool   Aligned;     // UnpackAlignmentFor, or 1
+                Expand Expansion;
+            };
+            const Variant variants[] =
+            {
+                { "1 channel, alignment 1",              1, false, Expand::None   },
+                { "1 channel, row alignment",            1, true,  Expand::None   },
+                { "3 channels, alignment 1",             3, false, Expand::None   },
+                { "3 channels, row alignment",           3, true,  Expand::None   },
+                { "3 channels, scalar expand + RGBA",    3, true,  Expand::Scalar },
+                { "3 channels, ExpandRGBToRGBA + RGBA",  3, true,  Expand::Simd   },
+                { "4 channels",                          4, true,  Expand::None   },
+            };
+
+            for (const Variant& variant : variants)
+            {
+                const int channels = variant.Expansion == Expand::None ? variant.Channels : 4;
+                const PixelFormat format = PixelFormatFor(channels);
+
+                GLTexture texture = GLTexture::create();
+                GLState.bindTexture(GL_TEXTURE_2D, texture.id());
+                glTexImage2D(GL_TEXTURE_2D, 0, format.Internal, size, size, 0, format.Format, GL_UNSIGNED_BYTE, NULL);
+
+                const unsigned char * pixels = variant.Expansion == Expand::None ? source.data() : expanded.data();
+                const GLint alignment = variant.Aligned ? UnpackAlignmentFor((size_t)size * channels, (uintptr_t)pixels) : 1;
+
+                auto upload = [&](int)
+                {
+                    if (variant.Expansion == Expand::Scalar)
+                        ExpandScalar(source.data(), expanded.data(), texels);
+                    else if (variant.Expansion == Expand::Simd)
+                        ExpandRGBToRGBA(source.data(), expanded.data(), texels);
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.Format, GL_UNSIGNED_BYTE, pixels);
+                };
+
+                glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+                upload(0);
+                const double ns = bench::NanosecondsPerIteration(iterations, upload);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+                std::printf("  %-36s %10.3f %10.1f   (alignment %d)\n", variant.Name, ns / 1e6,
+                            megapixels / (ns / 1e9), alignment);
+            }
+        }
+
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,109 @@
+//
+//  uniform_setters.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 6/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Cost of Shader::set* before (glGetUniformLocation per call) and
+//  after the link-time uniform table, by name and by handle.
+//
+
+#include "bench.h"
+#include "Shader.h"
+
+#include <cstdio>
+
+// Shader Source
+/*---------------------------------*/
+const char * VertexPath   = "bench_uniforms.vs";
+const char * FragmentPath = "bench_uniforms.fs";
+
+const char * VertexSource =
+"#version 330 core\n"
+"layout (location = 0) in vec3 Vertex;\n"
+"uniform float uScale;\n"
+"uniform float uOffsets[8];\n"
+"void main()\n"
+"{\n"
+"   gl_Position = vec4(Vertex * uScale + uOffsets[gl_VertexID % 8], 1.0);\n"
+"}\n";
+
+const char * FragmentSource =
+"#version 330 core\n"
+"layout(location = 0) out vec4 Color;\n"
+"uniform sampler2D uTexture1;\n"
+"uniform sampler2D uTexture2;\n"
+"uniform float uBlend;\n"
+"uniform bool uEnabled;\n"
+"void main()\n"
+"{\n"
+"   vec4 a = texture(uTexture1, vec2(0.5));\n"
+"   vec4 b = texture(uTexture2, vec2(0.5));\n"
+"   Color = uEnabled ? mix(a, b, uBlend) : a;\n"
+"}\n";
+
+static void WriteFile(const char * path, const char * source)
+{
+    if (FILE *file = ::fopen(path, "w"))
+    {
+        fputs(source, file);
+        fclose(file);
+    }
+}
+
+int main(int argc, const char * argv[])
+{
+    const int iterations = 1000000;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        WriteFile(VertexPath, VertexSource);
+        WriteFile(FragmentPath, FragmentSource);
+
+        Shader shader(VertexPath, FragmentPath);
+        shader.use();
+
+        const std::string blendName = "uBlend";
+
+        // Before: string lookup through the driver on every call
+        double legacy = bench::NanosecondsPerIteration(iterations, [&](int i) {
+            glUniform1f(glGetUniformLocation(shader.ID, blendName.c_str()), (float)i);
+        });
+
+        // After: string lookup in the link-time table
+        double byName = bench::NanosecondsPerIteration(iterations, [&](int i) {
+            shader.setFloat(blendName, (float)i);
+        });
+
+        // After: hash resolved at compile time
+        double byHash = bench::NanosecondsPerIteration(iterations, [&](int i) {
+            shader.setFloat(shader.getUniform(HashUniformName("uBlend")), (float)i);
+        });
+
+        // After: handle resolved once outside the loop
+        UniformHandle blend = shader.getUniform("uBlend");
+        double byHandle = bench::NanosecondsPerIteration(iterations, [&](int i) {
+            shader.setFloat(blend, (float)i);
+        });
+
+        std::printf("%-28s %10s\n", "setter", "ns/call");
+        std::printf("%-28s %10.1f\n", "glGetUniformLocation", legacy);
+        std::printf("%-28s %10.1f\n", "table (std::string)", byName);
+        std::printf("%-28s %10.1f\n", "table (constexpr hash)", byHash);
+        std::printf("%-28s %10.1f\n", "handle", byHandle);
+
+        std::remove(VertexPath);
+        std::remove(FragmentPath);
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,183 @@
+//
+//  vertex_layouts.cpp
+//  Benchmarks
+//
+//  Created by Crunchy on 7/25/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Vertex fetch for one mesh set up by VertexLayout both ways, the
+//  vertices interleaved and split into a stream per attribute, drawn
+//  by a positions-only pass (as for depth or shadows) and by a pass
+//  that reads every attribute. The vertex is 52 bytes, 12 of them
+//  position, so a positions-only pass over interleaved data fetches
+//  mostly bytes it throws away.
+//
+//      vertex_layouts [vertices] [iterations]
+//
+
+#include "bench.h"
+#include "GLDeletionQueue.h"
+#include "GLObject.h"
+#include "GLState.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+struct MeshVertex
+{
+    glm::vec3   Position;
+    glm::vec3   Normal;
+    glm::vec4   Tangent;
+    glm::vec2   UV;
+    glm::u8vec4 Colour;
+};
+using MeshVertexFormat = VertexLayout<MeshVertex,
+    VERTEX_ATTRIBUTE(MeshVertex, Position, 0),
+    VERTEX_ATTRIBUTE(MeshVertex, Normal,   1),
+    VERTEX_ATTRIBUTE(MeshVertex, Tangent,  2),
+    VERTEX_ATTRIBUTE(MeshVertex, UV,       3),
+    VERTEX_ATTRIBUTE_NORMALIZED(MeshVertex, Colour, 4)>;
+
+static const char * POSITION_VS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 Position;\n"
+    "void main() { gl_Position = vec4(Position, 1.0); }\n";
+
+static const char * FULL_VS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 Position;\n"
+    "layout (location = 1) in vec3 Normal;\n"
+    "layout (location = 2) in vec4 Tangent;\n"
+    "layout (location = 3) in vec2 UV;\n"
+    "layout (location = 4) in vec4 Colour;\n"
+    "out vec4 Shade;\n"
+    "void main()\n"
+    "{\n"
+    "    gl_Position = vec4(Position, 1.0);\n"
+    "    Shade = Colour * (dot(Normal, Tangent.xyz) * Tangent.w + UV.x + UV.y);\n"
+    "}\n";
+
+static const char * POSITION_FS =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main() { FragColor = vec4(1.0); }\n";
+
+static const char * FULL_FS =
+    "#version 330 core\n"
+    "in vec4 Shade;\n"
+    "out vec4 FragColor;\n"
+    "void main() { FragColor = Shade; }\n";
+
+static GLuint CompileProgram(const char * vertex, const char * fragment)
+{
+    GLuint program = glCreateProgram();
+    const char * sources[2] = { vertex, fragment };
+    const GLenum stages[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    for (int i = 0; i < 2; ++i)
+    {
+        GLuint shader = glCreateShader(stages[i]);
+        glShaderSource(shader, 1, &sources[i], NULL);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(program);
+
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+        throw std::runtime_error("Failed to link a benchmark program");
+    return program;
+}
+
+int main(int argc, const char * argv[])
+{
+    const int vertexCount = argc > 1 ? std::max(3, std::atoi(argv[1])) / 3 * 3 : 3 * 300000;
+    const int iterations  = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    try
+    {
+        GLFWwindow* window = bench::CreateHeadlessContext();
+
+        // Small triangles scattered over the viewport, so fetch and not
+        // fill is what gets measured
+        std::vector<MeshVertex> vertices((size_t)vertexCount);
+        for (int i = 0; i < vertexCount; ++i)
+        {
+            const int triangle = i / 3, corner = i % 3;
+            const float x = std::fmod(triangle * 0.618034f, 2.0f) - 1.0f;
+            const float y = std::fmod(triangle * 0.414214f, 2.0f) - 1.0f;
+            MeshVertex& vertex = vertices[i];
+            vertex.Position = glm::vec3(x + (corner == 1 ? 0.01f : 0.0f), y + (corner == 2 ? 0.01f : 0.0f), 0.0f);
+            vertex.Normal   = glm::vec3(0.0f, 0.0f, 1.0f);
+            vertex.Tangent  = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+            vertex.UV       = glm::vec2(corner == 1, corner == 2);
+            vertex.Colour   = glm::u8vec4(255, 128, 64, 255);
+        }
+
+        GLProgram positionOnly(CompileProgram(POSITION_VS, POSITION_FS));
+        GLProgram everything(CompileProgram(FULL_VS, FULL_FS));
+
+        std::printf("%d vertices of %zu bytes\n", vertexCount, sizeof(MeshVertex));
+        std::printf("%-14s %-16s %10s %12s %10s\n", "streams", "pass", "ms", "Mverts/s", "MB");
+
+        const VertexStreams arrangements[] = { VertexStreams::Interleaved, VertexStreams::Split };
+        for (VertexStreams streams : arrangements)
+        {
+            GLBuffer vbo = GLBuffer::create();
+            GLVertexArray vao = GLVertexArray::create();
+            GLState.bindVertexArray(vao.id());
+            GLState.bindBuffer(GL_ARRAY_BUFFER, vbo.id());
+            MeshVertexFormat::upload(vertices.data(), vertices.size(), streams);
+
+            const std::array<size_t, MeshVertexFormat::ATTRIBUTES + 1> offsets =
+                MeshVertexFormat::streamOffsets(streams, vertices.size());
+
+            struct Pass
+            {
+                const char * Name;
+                GLuint Program;
+                size_t Bytes;   // fetched per draw
+            };
+            const Pass passes[] =
+            {
+                { "positions only", positionOnly.id(),
+                  streams == VertexStreams::Split ? offsets[1] : offsets[MeshVertexFormat::ATTRIBUTES] },
+                { "every attribute", everything.id(), offsets[MeshVertexFormat::ATTRIBUTES] },
+            };
+
+            for (const Pass& pass : passes)
+            {
+                glUseProgram(pass.Program);
+                auto draw = [&](int)
+                {
+                    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+                };
+                draw(0);
+                const double ns = bench::NanosecondsPerIteration(iterations, draw);
+
+                std::printf("%-14s %-16s %10.3f %12.1f %10.1f\n",
+                            streams == VertexStreams::Split ? "split" : "interleaved", pass.Name, ns / 1e6,
+                            vertexCount / (ns / 1e3), pass.Bytes / 1e6);
+            }
+            GLState.bindVertexArray(0);
+        }
+
+        GLDeletions.flush();
+        glfwDestroyWindow(window);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception Thrown! " << e.what() << std::endl;
+    }
+
+    glfwTerminate();
+    return 0;
+}
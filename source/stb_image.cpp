@@ -0,0 +1,12 @@
+//
+//  stb_image.cpp
+//  Shaders
+//
+//  Created by Crunchy on 6/26/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  The one translation unit that compiles stb_image.
+//
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
@@ -0,0 +1,214 @@
+//
+//  bake_textures.cpp
+//  Tools
+//
+//  Created by Crunchy on 7/2/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Offline step that decodes every image in a directory once, builds
+//  its mip chain and writes a texture container per image:
+//
+//      bake_textures [--no-flip] [--raw] [--kaiser] [--linear] <image dir> <output dir>
+//
+//  images/wood.jpg becomes <output dir>/wood.jpg.tex. A container whose
+//  recorded source hash still matches is left alone, so rerunning it
+//  only bakes what changed. Rows are flipped for GL unless --no-flip.
+//  RGB images are stored as BC1 and RGBA as BC3 unless --raw; the
+//  encode rate and the top level's PSNR are printed per image. Mips are
+//  box filtered in linear light; --kaiser picks the sharper filter and
+//  --linear is for data that isn't sRGB colour (normal maps, masks).
+//
+
+#include "BlockCompression.h"
+#include "Hash.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "MipChain.h"
+#include "TextureContainer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+static std::vector<std::string> ListImages(const std::string& directory)
+{
+    std::vector<std::string> names;
+    if (DIR *handle = ::opendir(directory.c_str()))
+    {
+        while (dirent *entry = ::readdir(handle))
+        {
+            const std::string name = entry->d_name;
+            const std::string::size_type dot = name.rfind('.');
+            const std::string extension = dot == std::string::npos ? "" : name.substr(dot + 1);
+            if (extension == "png" || extension == "jpg" || extension == "jpeg" || extension == "tga" || extension == "bmp")
+                names.push_back(name);
+        }
+        ::closedir(handle);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+enum class BakeResult { Baked, UpToDate, Failed };
+
+struct BakeOptions
+{
+    bool Flip     = true;
+    bool Compress = true;
+    bool Kaiser   = false;
+    bool Srgb     = true;
+};
+
+// Block compression for colour images; grey ones stay as they are
+static TextureFormat FormatFor(int channels, const BakeOptions& options)
+{
+    if (options.Compress && channels == 3)
+        return TextureFormat::BC1;
+    if (options.Compress && channels == 4)
+        return TextureFormat::BC3;
+    return static_cast<TextureFormat>(channels);
+}
+
+static BakeResult Bake(const std::string& input, const std::string& output, const BakeOptions& options, ThreadPool& pool)
+{
+    MappedFile file(input);
+    if (!file.isOpen())
+    {
+        std::cerr << "ERROR::BAKE_TEXTURES::READ_FAILED Path=" << input << " (" << file.error() << ")" << std::endl;
+        return BakeResult::Failed;
+    }
+
+    // The options change the output, so they are part of the hash
+    const bool flags[4] = { options.Flip, options.Compress, options.Kaiser, options.Srgb };
+    const uint64_t hash = HashBytes(file.data(), file.size(), HashBytes(flags, sizeof(flags)));
+    if (TextureContainer::readSourceHash(output) == hash)
+        return BakeResult::UpToDate;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // Flipped per call rather than through stbi's global setting
+    ImageDecodeOptions decode;
+    decode.FlipVertically = options.Flip;
+    DecodedPixels pixels = ImageDecoder::decode(file.data(), file.size(), decode);
+    if (!pixels.isValid())
+    {
+        std::cerr << "ERROR::BAKE_TEXTURES::DECODE_FAILED Path=" << input << " (" << pixels.error() << ")" << std::endl;
+        return BakeResult::Failed;
+    }
+    const int width = pixels.width(), height = pixels.height(), channels = pixels.channels();
+
+    MipOptions mips;
+    mips.Filter = options.Kaiser ? MipFilter::Kaiser : MipFilter::Box;
+    mips.Srgb   = options.Srgb;
+    mips.Pool   = &pool;
+    const std::vector<MipImage> chain = GenerateMipChain(pixels.data(), width, height, channels, mips);
+    std::vector<TextureLevel> levels;
+    for (const MipImage& image : chain)
+        levels.push_back(image.level());
+
+    // Compress every level; the blocks must outlive the write
+    const TextureFormat format = FormatFor(channels, options);
+    std::vector<std::vector<unsigned char>> blocks;
+    double encodeMs = 0.0, psnr = 0.0;
+    size_t texels = 0;
+    if (TextureContainer::isCompressed(format))
+    {
+        std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+        for (TextureLevel& level : levels)
+        {
+            blocks.push_back(CompressBlocks(format, level.Data, level.Width, level.Height, channels, &pool));
+            texels += (size_t)level.Width * level.Height;
+            level.Data = blocks.back().data();
+            level.Size = blocks.back().size();
+        }
+        encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+
+        const std::vector<unsigned char> decoded = DecompressBlocks(format, blocks[0].data(), width, height);
+        psnr = BlockPsnr(chain[0].Pixels.data(), channels, decoded.data(), width, height);
+    }
+
+    std::string error;
+    if (!TextureContainer::write(output, format, options.Flip, hash, levels, error))
+    {
+        std::cerr << "ERROR::BAKE_TEXTURES::WRITE_FAILED Path=" << output << " (" << error << ")" << std::endl;
+        return BakeResult::Failed;
+    }
+
+    size_t rawBytes = 0, bakedBytes = 0;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        rawBytes   += chain[i].Pixels.size();
+        bakedBytes += levels[i].Size;
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Baked %s: %dx%d, %d channel(s), %zu level(s), %.1f ms\n",
+                output.c_str(), width, height, channels, levels.size(), ms);
+    if (TextureContainer::isCompressed(format))
+    {
+        std::printf("  %s: %.1f MP/s on %zu thread(s), PSNR %.2f dB, %zu KB -> %zu KB (%.1fx)\n",
+                    format == TextureFormat::BC1 ? "BC1" : "BC3", texels / (encodeMs * 1000.0), pool.size() + 1,
+                    psnr, rawBytes / 1024, bakedBytes / 1024, (double)rawBytes / bakedBytes);
+    }
+    return BakeResult::Baked;
+}
+
+int main(int argc, const char * argv[])
+{
+    BakeOptions options;
+    std::vector<std::string> arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--no-flip") == 0)
+            options.Flip = false;
+        else if (std::strcmp(argv[i], "--raw") == 0)
+            options.Compress = false;
+        else if (std::strcmp(argv[i], "--kaiser") == 0)
+            options.Kaiser = true;
+        else if (std::strcmp(argv[i], "--linear") == 0)
+            options.Srgb = false;
+        else
+            arguments.push_back(argv[i]);
+    }
+
+    if (arguments.size() != 2)
+    {
+        std::cerr << "usage: bake_textures [--no-flip] [--raw] [--kaiser] [--linear] <image dir> <output dir>" << std::endl;
+        return 1;
+    }
+
+    const std::vector<std::string> names = ListImages(arguments[0]);
+    if (names.empty())
+    {
+        std::cerr << "ERROR::BAKE_TEXTURES::NO_FILES Path=" << arguments[0] << std::endl;
+        return 1;
+    }
+
+    // An existing directory is fine; anything else shows up as write failures
+    ::mkdir(arguments[1].c_str(), 0755);
+
+    // parallelFor runs on the caller too, so one worker fewer
+    ThreadPool pool(std::max<size_t>(1, ThreadPool::hardwareThreads() - 1));
+
+    int baked = 0, upToDate = 0, failed = 0;
+    for (const std::string& name : names)
+    {
+        switch (Bake(arguments[0] + "/" + name, arguments[1] + "/" + name + ".tex", options, pool))
+        {
+            case BakeResult::Baked:    ++baked;    break;
+            case BakeResult::UpToDate: ++upToDate; break;
+            case BakeResult::Failed:   ++failed;   break;
+        }
+    }
+
+    std::printf("%d baked, %d up to date, %d failed\n", baked, upToDate, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,230 @@
+//
+//  embed_shaders.cpp
+//  Tools
+//
+//  Created by Crunchy on 6/20/20.
+//  Copyright © 2020 AnOrganization. All rights reserved.
+//
+//  Build step that turns every file under the shader directory into
+//  constexpr string data:
+//
+//      embed_shaders <shader dir> <output include dir>
+//
+//  writes ShaderResources.h (one ShaderResource ID per file) and
+//  EmbeddedShaderData.h (the text and its size). Outputs are
+//  only rewritten when they change, so an unchanged shaders/ does not
+//  trigger a rebuild. Run it before compiling, e.g. as an Xcode
+//  "Run Script" phase.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+struct SourceFile
+{
+    std::string Path;   // relative to the shader directory
+    std::string Name;   // ShaderResource enumerator
+    std::string Data;
+};
+
+// Recursively collects regular files, skipping dotfiles
+static void Collect(const std::string& root, const std::string& relative, std::vector<SourceFile>& files)
+{
+    const std::string directory = relative.empty() ? root : root + "/" + relative;
+    DIR *handle = ::opendir(directory.c_str());
+    if (!handle)
+        return;
+
+    while (dirent *entry = ::readdir(handle))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        const std::string path = relative.empty() ? entry->d_name : relative + "/" + entry->d_name;
+        const std::string full = root + "/" + path;
+
+        struct stat info;
+        if (::stat(full.c_str(), &info) != 0)
+            continue;
+
+        if (S_ISDIR(info.st_mode))
+        {
+            Collect(root, path, files);
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            std::ifstream stream(full, std::ios::binary);
+            std::stringstream buffer;
+            buffer << stream.rdbuf();
+
+            SourceFile file;
+            file.Path = path;
+            file.Data = buffer.str();
+            files.push_back(file);
+        }
+    }
+    ::closedir(handle);
+}
+
+// "fragment/blend.texture2.fs" -> "fragment_blend_texture2_fs"
+static std::string Identifier(const std::string& path)
+{
+    std::string name = path;
+    for (char& c : name)
+    {
+        if (!std::isalnum(static_cast<unsigned char>(c)))
+            c = '_';
+    }
+    if (!name.empty() && std::isdigit(static_cast<unsigned char>(name[0])))
+        name.insert(0, "_");
+    return name;
+}
+
+// One string literal piece per source line
+static std::string Literal(const std::string& data)
+{
+    std::string literal = "        \"";
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        switch (c)
+        {
+            case '\\': literal += "\\\\"; break;
+            case '"':  literal += "\\\""; break;
+            case '\t': literal += "\\t";  break;
+            case '\r': literal += "\\r";  break;
+            case '\n':
+                literal += "\\n\"";
+                if (i + 1 < data.size())
+                    literal += "\n        \"";
+                else
+                    return literal;
+                break;
+            default:
+                if (c < 0x20 || c >= 0x7F)
+                {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\%03o", c);
+                    literal += escape;
+                }
+                else
+                {
+                    literal += static_cast<char>(c);
+                }
+        }
+    }
+    return literal + "\"";
+}
+
+static const char * Banner(const char * name)
+{
+    static std::string banner;
+    banner = std::string("//\n//  ") + name + "\n//  Shaders\n//\n"
+             "//  Generated by source/tools/embed_shaders.cpp. Do not edit.\n//\n\n";
+    return banner.c_str();
+}
+
+static std::string ResourcesHeader(const std::vector<SourceFile>& files)
+{
+    std::ostringstream out;
+    out << Banner("ShaderResources.h")
+        << "#ifndef ShaderResources_h\n#define ShaderResources_h\n\n"
+        << "#include <cstddef>\n\n"
+        << "enum class ShaderResource : size_t\n{\n";
+    for (const SourceFile& file : files)
+        out << "    " << file.Name << ",\n";
+    out << "};\n\n"
+        << "const size_t SHADER_RESOURCE_COUNT = " << files.size() << ";\n\n"
+        << "#endif\n";
+    return out.str();
+}
+
+static std::string DataHeader(const std::vector<SourceFile>& files)
+{
+    std::ostringstream out;
+    out << Banner("EmbeddedShaderData.h")
+        << "// Included by EmbeddedShaders.cpp only\n\n"
+        << "#ifndef EmbeddedShaderData_h\n#define EmbeddedShaderData_h\n\n"
+        << "#include \"EmbeddedShaders.h\"\n\n"
+        << "namespace EmbeddedShaderData\n{\n";
+
+    for (const SourceFile& file : files)
+    {
+        out << "    // " << file.Path << "\n"
+            << "    constexpr char " << file.Name << "[] =\n"
+            << Literal(file.Data) << ";\n\n";
+    }
+
+    out << "    // In ShaderResource order\n"
+        << "    constexpr EmbeddedFile Files[] =\n    {\n";
+    for (const SourceFile& file : files)
+    {
+        out << "        { \"" << file.Path << "\", " << file.Name << ", "
+            << file.Data.size() << " },\n";
+    }
+    out << "    };\n\n"
+        << "    static_assert(sizeof(Files) / sizeof(Files[0]) == SHADER_RESOURCE_COUNT, \"Regenerate ShaderResources.h\");\n"
+        << "}\n\n#endif\n";
+    return out.str();
+}
+
+// Leaves the file (and its timestamp) alone if nothing changed
+static bool WriteIfChanged(const std::string& path, const std::string& contents)
+{
+    std::ifstream existing(path, std::ios::binary);
+    if (existing)
+    {
+        std::stringstream buffer;
+        buffer << existing.rdbuf();
+        if (buffer.str() == contents)
+            return true;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+    if (!out)
+    {
+        std::cerr << "ERROR::EMBED_SHADERS::WRITE_FAILED Path=" << path << std::endl;
+        return false;
+    }
+    std::cout << "Wrote " << path << std::endl;
+    return true;
+}
+
+int main(int argc, const char * argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: embed_shaders <shader dir> <output include dir>" << std::endl;
+        return 1;
+    }
+
+    std::vector<SourceFile> files;
+    Collect(argv[1], "", files);
+    if (files.empty())
+    {
+        std::cerr << "ERROR::EMBED_SHADERS::NO_FILES Path=" << argv[1] << std::endl;
+        return 1;
+    }
+
+    // readdir order is arbitrary; IDs must be stable between runs
+    std::sort(files.begin(), files.end(),
+              [](const SourceFile& a, const SourceFile& b) { return a.Path < b.Path; });
+
+    for (SourceFile& file : files)
+        file.Name = Identifier(file.Path);
+
+    const std::string output = argv[2];
+    bool written = WriteIfChanged(output + "/ShaderResources.h", ResourcesHeader(files));
+    written = WriteIfChanged(output + "/EmbeddedShaderData.h", DataHeader(files)) && written;
+    return written ? 0 : 1;
+}